@@ -0,0 +1,225 @@
+#include "benchmark.h"
+
+#include <charconv>
+#include <cstdio>
+#include <ostream>
+#include <stdexcept>
+
+namespace
+{
+
+int parse_int(std::string_view option, std::string_view value)
+{
+	int result = 0;
+	auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), result);
+	if (error != std::errc() || end != value.data() + value.size() || result < 0)
+		throw std::runtime_error("Invalid value for " + std::string(option) + ": " + std::string(value));
+	return result;
+}
+
+void print_histogram(std::ostream & out, char const * label, rolling_histogram const & histogram)
+{
+	char buffer[160];
+	std::snprintf(buffer, sizeof(buffer), "  %-16s mean %8.3f ms  p50 %8.3f  p95 %8.3f  p99 %8.3f  max %8.3f\n",
+		label, histogram.mean(), histogram.percentile(50.f), histogram.percentile(95.f), histogram.percentile(99.f), histogram.max());
+	out << buffer;
+}
+
+}
+
+Uint32 benchmark_options::window_flags() const
+{
+	if (headless)
+		return SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN;
+	return SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE | SDL_WINDOW_MAXIMIZED;
+}
+
+benchmark_options parse_benchmark_options(int argc, char ** argv, std::vector<std::string_view> * rest)
+{
+	benchmark_options result;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string_view arg = argv[i];
+
+		auto value = [&]() -> std::string_view {
+			if (i + 1 >= argc)
+				throw std::runtime_error("Missing value for " + std::string(arg));
+			return argv[++i];
+		};
+
+		if (arg == "--headless")
+			result.headless = true;
+		else if (arg == "--frames")
+			result.frames = parse_int(arg, value());
+		else if (arg == "--warmup")
+			result.warmup = parse_int(arg, value());
+		else if (arg == "--scene")
+			result.scene_size = parse_int(arg, value());
+		else if (arg == "--vsync")
+		{
+			std::string_view mode = value();
+			if (mode == "on")
+				result.pacing.mode = pacing_mode::vsync;
+			else if (mode == "adaptive")
+				result.pacing.mode = pacing_mode::adaptive;
+			else if (mode == "off")
+				result.pacing.mode = pacing_mode::uncapped;
+			else
+				throw std::runtime_error("Invalid value for --vsync: " + std::string(mode));
+		}
+		else if (arg == "--fps")
+		{
+			result.pacing.mode = pacing_mode::limited;
+			result.pacing.target_fps = parse_int(arg, value());
+		}
+		else if (arg == "--redraw")
+		{
+			std::string_view mode = value();
+			if (mode == "continuous")
+				result.pacing.redraw = redraw_mode::continuous;
+			else if (mode == "on-demand")
+				result.pacing.redraw = redraw_mode::on_demand;
+			else
+				throw std::runtime_error("Invalid value for --redraw: " + std::string(mode));
+		}
+		else if (arg == "--frames-in-flight")
+			result.pacing.frames_in_flight = parse_int(arg, value());
+		else if (arg == "--resolution")
+		{
+			std::string_view size = value();
+			auto x = size.find('x');
+			if (x == std::string_view::npos)
+				throw std::runtime_error("Invalid value for --resolution: " + std::string(size));
+			result.width = parse_int(arg, size.substr(0, x));
+			result.height = parse_int(arg, size.substr(x + 1));
+		}
+		else if (rest)
+			rest->push_back(arg);
+		else
+			throw std::runtime_error("Unknown argument: " + std::string(arg));
+	}
+
+	if (result.frames == 0 || result.width == 0 || result.height == 0)
+		throw std::runtime_error("Benchmark frame count and resolution must be positive");
+	if (result.pacing.mode == pacing_mode::limited && result.pacing.target_fps == 0)
+		throw std::runtime_error("The --fps limit must be positive");
+
+	return result;
+}
+
+benchmark::benchmark(benchmark_options const & options, std::string name)
+	: options_(options)
+	, name_(std::move(name))
+	, latency_(options.frames)
+	, cpu_frame_(options.frames)
+{
+	glGenRenderbuffers(1, &color_renderbuffer_);
+	glBindRenderbuffer(GL_RENDERBUFFER, color_renderbuffer_);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, options_.width, options_.height);
+
+	glGenRenderbuffers(1, &depth_renderbuffer_);
+	glBindRenderbuffer(GL_RENDERBUFFER, depth_renderbuffer_);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, options_.width, options_.height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &framebuffer_);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color_renderbuffer_);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth_renderbuffer_);
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		throw std::runtime_error("Offscreen framebuffer is incomplete");
+
+	glViewport(0, 0, options_.width, options_.height);
+
+	glGenQueries(end_queries_.size(), end_queries_.data());
+}
+
+benchmark::~benchmark()
+{
+	for (auto const & frame : pending_)
+		glDeleteSync(frame.fence);
+	glDeleteQueries(end_queries_.size(), end_queries_.data());
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDeleteFramebuffers(1, &framebuffer_);
+	glDeleteRenderbuffers(1, &depth_renderbuffer_);
+	glDeleteRenderbuffers(1, &color_renderbuffer_);
+}
+
+void benchmark::begin_frame()
+{
+	frame_start_ = clock::now();
+	if (frame_ == options_.warmup)
+		measure_start_ = frame_start_;
+
+	// The current GPU time, without waiting for queued commands
+	glGetInteger64v(GL_TIMESTAMP, &gpu_frame_start_);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+}
+
+bool benchmark::end_frame()
+{
+	bool measured = frame_ >= options_.warmup;
+	if (measured)
+		cpu_frame_.add(std::chrono::duration<float, std::milli>(clock::now() - frame_start_).count());
+
+	// At most max_frames_in_flight - 1 frames are pending here, so the
+	// query of this slot has been read already
+	GLuint end_query = end_queries_[frame_ % max_frames_in_flight];
+	glQueryCounter(end_query, GL_TIMESTAMP);
+	pending_.push_back({glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), end_query, gpu_frame_start_, measured});
+	glFlush();
+
+	++frame_;
+	bool finished = frame_ >= options_.warmup + options_.frames;
+
+	while (pending_.size() > (finished ? 0 : max_frames_in_flight - 1))
+	{
+		retire(pending_.front());
+		pending_.pop_front();
+	}
+
+	if (finished)
+		measure_end_ = clock::now();
+
+	return !finished;
+}
+
+void benchmark::retire(pending_frame const & frame)
+{
+	while (glClientWaitSync(frame.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64(1000000000)) == GL_TIMEOUT_EXPIRED)
+		;
+	glDeleteSync(frame.fence);
+
+	// Available once the fence after it has signaled
+	GLint64 gpu_end = 0;
+	glGetQueryObjecti64v(frame.end_query, GL_QUERY_RESULT, &gpu_end);
+
+	if (frame.measured)
+		latency_.add(float(gpu_end - frame.gpu_start) * 1e-6f);
+}
+
+void benchmark::report(std::ostream & out, frame_profiler const & profiler) const
+{
+	float seconds = std::chrono::duration<float>(measure_end_ - measure_start_).count();
+
+	char buffer[160];
+	std::snprintf(buffer, sizeof(buffer), "%s: %d frames at %dx%d in %.3f s, %.1f frames/s\n",
+		name_.c_str(), options_.frames, options_.width, options_.height, seconds, options_.frames / seconds);
+	out << buffer;
+
+	print_histogram(out, "latency", latency_);
+	print_histogram(out, "cpu frame", cpu_frame_);
+
+	// The profiler keeps a window of the latest frames only, which may
+	// include some of the warmup when the run is short
+	if (profiler.gpu_times().count() > 0)
+		print_histogram(out, "gpu", profiler.gpu_times());
+	for (auto const & s : profiler.sections())
+		print_histogram(out, s.name.c_str(), s.histogram);
+
+	out.flush();
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#ifdef WIN32
+#include <SDL.h>
+#else
+#include <SDL2/SDL.h>
+#endif
+
+#include <GL/glew.h>
+
+#include <array>
+#include <chrono>
+#include <deque>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "profiler.h"
+#include "frame_pacer.h"
+
+// Command line options understood by every practice target:
+//   --headless          render offscreen for a fixed number of frames, print statistics and exit
+//   --frames N          number of measured frames (default 1000)
+//   --warmup N          frames rendered before measuring starts (default 100)
+//   --resolution WxH    size of the offscreen framebuffer (default 1280x720)
+//   --scene N           scene size; its meaning is target-specific, 0 keeps the default
+// and, for windowed runs (see frame_pacer):
+//   --vsync MODE        on (default), adaptive or off
+//   --fps N             start frames at most N times per second; implies --vsync off
+//   --frames-in-flight N  frames queued on the GPU at most (default 2, 0 leaves it to the driver)
+//   --redraw MODE       continuous or on-demand; the default depends on the target
+struct benchmark_options
+{
+	bool headless = false;
+	int frames = 1000;
+	int warmup = 100;
+	int width = 1280;
+	int height = 720;
+	int scene_size = 0;
+	pacing_options pacing;
+
+	// Flags for SDL_CreateWindow; in headless mode the window is hidden
+	// and only exists to own the GL context
+	Uint32 window_flags() const;
+};
+
+// Removes the options above from the command line. Arguments that aren't
+// benchmark options are stored in `rest` in their original order, or are
+// an error if `rest` is null.
+benchmark_options parse_benchmark_options(int argc, char ** argv, std::vector<std::string_view> * rest = nullptr);
+
+// Drives a headless run. Frames are rendered into an offscreen framebuffer
+// instead of the window, the scene is advanced with a fixed time step so that
+// every run does exactly the same work, and the latency of each frame (from
+// the start of its CPU work to GPU completion) is measured on the GPU clock:
+// GL_TIMESTAMP is read when the frame begins and a timestamp query is
+// written after its last command, so when the CPU gets to the result
+// doesn't matter. Like a swap chain, at most `max_frames_in_flight` frames
+// are queued on the GPU; fences wait for the oldest one.
+class benchmark
+{
+public:
+	static constexpr float time_step = 1.f / 60.f;
+	static constexpr std::size_t max_frames_in_flight = 2;
+
+	benchmark(benchmark_options const & options, std::string name);
+	~benchmark();
+
+	benchmark(benchmark const &) = delete;
+	benchmark & operator = (benchmark const &) = delete;
+
+	int width() const { return options_.width; }
+	int height() const { return options_.height; }
+
+	// Binds the offscreen framebuffer; call before any rendering of the frame
+	void begin_frame();
+
+	// Returns false once all warmup and measured frames have been rendered
+	bool end_frame();
+
+	// Prints throughput and latency statistics, plus the CPU sections and
+	// GPU time of `profiler` over the measured frames
+	void report(std::ostream & out, frame_profiler const & profiler) const;
+
+private:
+	using clock = std::chrono::steady_clock;
+
+	struct pending_frame
+	{
+		GLsync fence;
+		// GL_TIMESTAMP query written after the last command of the frame
+		GLuint end_query;
+		// GPU time in nanoseconds when the frame began on the CPU
+		GLint64 gpu_start;
+		bool measured;
+	};
+
+	benchmark_options options_;
+	std::string name_;
+
+	GLuint framebuffer_ = 0;
+	GLuint color_renderbuffer_ = 0;
+	GLuint depth_renderbuffer_ = 0;
+
+	std::deque<pending_frame> pending_;
+	// Used in turn, one per frame in flight
+	std::array<GLuint, max_frames_in_flight> end_queries_{};
+	int frame_ = 0;
+	clock::time_point frame_start_;
+	GLint64 gpu_frame_start_ = 0;
+	clock::time_point measure_start_;
+	clock::time_point measure_end_;
+
+	rolling_histogram latency_;
+	rolling_histogram cpu_frame_;
+
+	void retire(pending_frame const & frame);
+};
@@ -0,0 +1,253 @@
+#include "culling.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace
+{
+
+// Bit i of `outside` is set if box i is completely behind one of the
+// planes, bit i of `straddling` if it is not completely in front of all
+// of them (so `outside` is a subset of `straddling`)
+struct block_result
+{
+	unsigned outside;
+	unsigned straddling;
+};
+
+template <typename Block>
+block_result test_block(Block const & block, std::array<vec4, 6> const & planes)
+{
+#if defined(VECTOR_MATH_SSE)
+	__m128 const cx = _mm_load_ps(block.center[0]);
+	__m128 const cy = _mm_load_ps(block.center[1]);
+	__m128 const cz = _mm_load_ps(block.center[2]);
+	__m128 const ex = _mm_load_ps(block.extent[0]);
+	__m128 const ey = _mm_load_ps(block.extent[1]);
+	__m128 const ez = _mm_load_ps(block.extent[2]);
+	__m128 const zero = _mm_setzero_ps();
+
+	__m128 outside = zero, straddling = zero;
+	for (vec4 const & p : planes)
+	{
+		__m128 const distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, _mm_set1_ps(p.x)), _mm_mul_ps(cy, _mm_set1_ps(p.y))),
+			_mm_add_ps(_mm_mul_ps(cz, _mm_set1_ps(p.z)), _mm_set1_ps(p.w)));
+		__m128 const radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ex, _mm_set1_ps(std::abs(p.x))), _mm_mul_ps(ey, _mm_set1_ps(std::abs(p.y)))),
+			_mm_mul_ps(ez, _mm_set1_ps(std::abs(p.z))));
+		outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), zero));
+		straddling = _mm_or_ps(straddling, _mm_cmplt_ps(_mm_sub_ps(distance, radius), zero));
+	}
+	return {unsigned(_mm_movemask_ps(outside)), unsigned(_mm_movemask_ps(straddling))};
+#elif defined(VECTOR_MATH_NEON)
+	float32x4_t const cx = vld1q_f32(block.center[0]);
+	float32x4_t const cy = vld1q_f32(block.center[1]);
+	float32x4_t const cz = vld1q_f32(block.center[2]);
+	float32x4_t const ex = vld1q_f32(block.extent[0]);
+	float32x4_t const ey = vld1q_f32(block.extent[1]);
+	float32x4_t const ez = vld1q_f32(block.extent[2]);
+	float32x4_t const zero = vdupq_n_f32(0.f);
+
+	uint32x4_t outside = vdupq_n_u32(0), straddling = vdupq_n_u32(0);
+	for (vec4 const & p : planes)
+	{
+		float32x4_t distance = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(p.w), cx, p.x), cy, p.y), cz, p.z);
+		float32x4_t radius = vmlaq_n_f32(vmlaq_n_f32(vmulq_n_f32(ex, std::abs(p.x)), ey, std::abs(p.y)), ez, std::abs(p.z));
+		outside = vorrq_u32(outside, vcltq_f32(vaddq_f32(distance, radius), zero));
+		straddling = vorrq_u32(straddling, vcltq_f32(vsubq_f32(distance, radius), zero));
+	}
+
+	static std::uint32_t const lane_bits[4] = {1, 2, 4, 8};
+	uint32x4_t const bits = vld1q_u32(lane_bits);
+	auto mask = [&](uint32x4_t m){
+		uint32x4_t const b = vandq_u32(m, bits);
+		return unsigned(vgetq_lane_u32(b, 0) | vgetq_lane_u32(b, 1) | vgetq_lane_u32(b, 2) | vgetq_lane_u32(b, 3));
+	};
+	return {mask(outside), mask(straddling)};
+#else
+	block_result result{0, 0};
+	for (int lane = 0; lane < 4; ++lane)
+	{
+		for (vec4 const & p : planes)
+		{
+			float const distance = block.center[0][lane] * p.x + block.center[1][lane] * p.y + block.center[2][lane] * p.z + p.w;
+			float const radius = block.extent[0][lane] * std::abs(p.x) + block.extent[1][lane] * std::abs(p.y) + block.extent[2][lane] * std::abs(p.z);
+			if (distance + radius < 0.f)
+				result.outside |= 1u << lane;
+			if (distance - radius < 0.f)
+				result.straddling |= 1u << lane;
+		}
+	}
+	return result;
+#endif
+}
+
+template <typename Block>
+void store_box(Block & block, std::size_t lane, aabb const & box)
+{
+	vec3 const center = (box.min + box.max) * 0.5f;
+	vec3 const extent = (box.max - box.min) * 0.5f;
+	block.center[0][lane] = center.x;
+	block.center[1][lane] = center.y;
+	block.center[2][lane] = center.z;
+	block.extent[0][lane] = extent.x;
+	block.extent[1][lane] = extent.y;
+	block.extent[2][lane] = extent.z;
+}
+
+aabb merge(aabb const & a, aabb const & b)
+{
+	return
+	{
+		{std::min(a.min.x, b.min.x), std::min(a.min.y, b.min.y), std::min(a.min.z, b.min.z)},
+		{std::max(a.max.x, b.max.x), std::max(a.max.y, b.max.y), std::max(a.max.z, b.max.z)},
+	};
+}
+
+unsigned lane_mask(std::size_t count)
+{
+	return count >= 4 ? 0xfu : (1u << count) - 1;
+}
+
+}
+
+frustum::frustum(mat4 const & m)
+{
+	vec4 const row0{m[0].x, m[1].x, m[2].x, m[3].x};
+	vec4 const row1{m[0].y, m[1].y, m[2].y, m[3].y};
+	vec4 const row2{m[0].z, m[1].z, m[2].z, m[3].z};
+	vec4 const row3{m[0].w, m[1].w, m[2].w, m[3].w};
+
+	planes_ =
+	{
+		row3 + row0, row3 - row0,
+		row3 + row1, row3 - row1,
+		row3 + row2, row3 - row2,
+	};
+}
+
+bool frustum::intersects(aabb const & box) const
+{
+	vec3 const center = (box.min + box.max) * 0.5f;
+	vec3 const extent = (box.max - box.min) * 0.5f;
+	for (vec4 const & p : planes_)
+	{
+		float const distance = center.x * p.x + center.y * p.y + center.z * p.z + p.w;
+		float const radius = extent.x * std::abs(p.x) + extent.y * std::abs(p.y) + extent.z * std::abs(p.z);
+		if (distance + radius < 0.f)
+			return false;
+	}
+	return true;
+}
+
+cull_grid::cull_grid(std::span<aabb const> bounds, float cell_size)
+	: object_count_(bounds.size())
+{
+	if (bounds.empty())
+		return;
+
+	vec3 origin = (bounds[0].min + bounds[0].max) * 0.5f;
+	vec3 end = origin;
+	for (auto const & box : bounds)
+	{
+		vec3 const center = (box.min + box.max) * 0.5f;
+		origin = {std::min(origin.x, center.x), std::min(origin.y, center.y), std::min(origin.z, center.z)};
+		end = {std::max(end.x, center.x), std::max(end.y, center.y), std::max(end.z, center.z)};
+	}
+
+	// Capped so that a tiny cell size can't allocate an absurd grid
+	auto cells_along = [&](float extent){
+		return std::clamp<std::size_t>(std::size_t(extent / cell_size) + 1, 1, 1024);
+	};
+	std::size_t const size_x = cells_along(end.x - origin.x);
+	std::size_t const size_y = cells_along(end.y - origin.y);
+	std::size_t const size_z = cells_along(end.z - origin.z);
+
+	auto cell_index = [&](aabb const & box){
+		vec3 const offset = (box.min + box.max) * 0.5f - origin;
+		auto coordinate = [&](float value, std::size_t size){
+			return std::min(std::size_t(std::max(value / cell_size, 0.f)), size - 1);
+		};
+		return (coordinate(offset.z, size_z) * size_y + coordinate(offset.y, size_y)) * size_x + coordinate(offset.x, size_x);
+	};
+
+	// Counting sort of the objects by cell
+	std::vector<std::uint32_t> object_cells(bounds.size());
+	std::vector<std::uint32_t> offsets(size_x * size_y * size_z + 1, 0);
+	for (std::size_t i = 0; i < bounds.size(); ++i)
+	{
+		object_cells[i] = cell_index(bounds[i]);
+		++offsets[object_cells[i] + 1];
+	}
+	for (std::size_t i = 1; i < offsets.size(); ++i)
+		offsets[i] += offsets[i - 1];
+
+	std::vector<std::uint32_t> sorted(bounds.size());
+	{
+		std::vector<std::uint32_t> next(offsets.begin(), offsets.end() - 1);
+		for (std::size_t i = 0; i < bounds.size(); ++i)
+			sorted[next[object_cells[i]]++] = i;
+	}
+
+	// Only non-empty cells are kept
+	std::vector<aabb> cell_bounds;
+	for (std::size_t c = 0; c + 1 < offsets.size(); ++c)
+	{
+		std::uint32_t const begin = offsets[c], count = offsets[c + 1] - begin;
+		if (count == 0)
+			continue;
+
+		std::uint32_t const first_block = object_blocks_.size();
+		std::uint32_t const block_count = (count + 3) / 4;
+		object_blocks_.resize(first_block + block_count, box_block{});
+		object_ids_.resize(4 * (first_block + block_count), 0);
+
+		aabb united = bounds[sorted[begin]];
+		for (std::uint32_t i = 0; i < count; ++i)
+		{
+			std::uint32_t const id = sorted[begin + i];
+			store_box(object_blocks_[first_block + i / 4], i % 4, bounds[id]);
+			object_ids_[4 * first_block + i] = id;
+			united = merge(united, bounds[id]);
+		}
+
+		cells_.push_back({first_block, block_count, count});
+		cell_bounds.push_back(united);
+	}
+
+	cell_blocks_.resize((cells_.size() + 3) / 4, box_block{});
+	for (std::size_t c = 0; c < cells_.size(); ++c)
+		store_box(cell_blocks_[c / 4], c % 4, cell_bounds[c]);
+}
+
+void cull_grid::cull(frustum const & f, std::vector<std::uint32_t> & visible)
+{
+	auto const & planes = f.planes();
+	last_cells_tested_ = cells_.size();
+	last_objects_tested_ = 0;
+
+	for (std::size_t cb = 0; cb < cell_blocks_.size(); ++cb)
+	{
+		auto const cell_result = test_block(cell_blocks_[cb], planes);
+		for (unsigned cells_left = ~cell_result.outside & lane_mask(cells_.size() - 4 * cb); cells_left != 0; cells_left &= cells_left - 1)
+		{
+			unsigned const lane = std::countr_zero(cells_left);
+			auto const & c = cells_[4 * cb + lane];
+			std::uint32_t const * ids = object_ids_.data() + 4 * c.first_block;
+
+			if (!(cell_result.straddling & (1u << lane)))
+			{
+				visible.insert(visible.end(), ids, ids + c.object_count);
+				continue;
+			}
+
+			last_objects_tested_ += c.object_count;
+			for (std::uint32_t b = 0; b < c.block_count; ++b)
+			{
+				auto const object_result = test_block(object_blocks_[c.first_block + b], planes);
+				for (unsigned objects_left = ~object_result.outside & lane_mask(c.object_count - 4 * b); objects_left != 0; objects_left &= objects_left - 1)
+					visible.push_back(ids[4 * b + std::countr_zero(objects_left)]);
+			}
+		}
+	}
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "vector_math.h"
+
+struct aabb
+{
+	vec3 min;
+	vec3 max;
+};
+
+// The six clip planes of a view-projection matrix (GL conventions, clip z
+// in [-w, w]), extracted as in Gribb and Hartmann: a point p is inside if
+// dot(plane, vec4(p, 1)) >= 0 for all of them. The planes are not
+// normalized, only the signs of the distances are used.
+class frustum
+{
+public:
+	explicit frustum(mat4 const & view_projection);
+
+	std::array<vec4, 6> const & planes() const { return planes_; }
+
+	// Conservative: boxes near a corner of the frustum may pass although
+	// they are outside of it
+	bool intersects(aabb const & box) const;
+
+private:
+	std::array<vec4, 6> planes_;
+};
+
+// Static object bounds bucketed by their centers into a uniform grid. Every
+// cell keeps the union of its objects' bounds, so objects may extend into
+// neighbouring cells. Culling tests the cells first; cells outside of the
+// frustum are skipped altogether and cells completely inside of it accept
+// all their objects untested, only the objects of the cells that straddle
+// a plane are tested one by one.
+//
+// Boxes are stored as centers and extents, four per block by component, so
+// that one SSE/NEON instruction tests four of them against a plane.
+class cull_grid
+{
+public:
+	// `cell_size` is the edge length of the grid cells in world units
+	cull_grid(std::span<aabb const> bounds, float cell_size);
+
+	// Appends the indices of the objects whose bounds intersect `f` to
+	// `visible`, grouped by cell
+	void cull(frustum const & f, std::vector<std::uint32_t> & visible);
+
+	std::size_t objects() const { return object_count_; }
+	std::size_t cells() const { return cells_.size(); }
+
+	// Statistics of the last cull
+	std::size_t cells_tested() const { return last_cells_tested_; }
+	std::size_t objects_tested() const { return last_objects_tested_; }
+
+private:
+	struct alignas(16) box_block
+	{
+		float center[3][4];
+		float extent[3][4];
+	};
+
+	struct cell
+	{
+		// Blocks in object_blocks_, and the same range x4 in object_ids_
+		std::uint32_t first_block;
+		std::uint32_t block_count;
+		std::uint32_t object_count;
+	};
+
+	std::size_t object_count_ = 0;
+	std::vector<cell> cells_;
+	std::vector<box_block> cell_blocks_;
+	std::vector<box_block> object_blocks_;
+	// Four per block, the padding of the last block of a cell is never read
+	std::vector<std::uint32_t> object_ids_;
+
+	std::size_t last_cells_tested_ = 0;
+	std::size_t last_objects_tested_ = 0;
+};
@@ -0,0 +1,114 @@
+#include "draw_queue.h"
+#include "vertex_format.h"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+draw_queue::draw_queue()
+	: indirect_(GLEW_VERSION_4_3 || GLEW_ARB_multi_draw_indirect)
+	, base_instance_(GLEW_VERSION_4_2 || GLEW_ARB_base_instance)
+{}
+
+void draw_queue::submit(draw_state const & state, draw_call const & call, float depth)
+{
+	if (call.base_instance != 0 && !base_instance_)
+		throw std::runtime_error("Draws with a base instance require GL 4.2 or ARB_base_instance");
+
+	auto it = std::find(states_.begin(), states_.end(), state);
+	if (it == states_.end())
+		it = states_.insert(it, state);
+
+	records_.push_back({std::uint32_t(it - states_.begin()), order_preserving_bits(depth), call});
+}
+
+void draw_queue::flush(gl_state & gl)
+{
+	last_draws_ = records_.size();
+	last_batches_ = 0;
+	if (records_.empty())
+		return;
+
+	rank_states();
+
+	keys_.resize(records_.size());
+	for (std::size_t i = 0; i < records_.size(); ++i)
+		keys_[i] = {(std::uint64_t(state_ranks_[records_[i].state]) << 32) | records_[i].depth, std::uint32_t(i)};
+	radix_sort(keys_, scratch_);
+
+	// Sorted commands are laid out contiguously, each batch is a range of them
+	commands_.resize(keys_.size());
+	for (std::size_t i = 0; i < keys_.size(); ++i)
+		commands_[i] = records_[keys_[i].index].call;
+	if (indirect_)
+		upload_commands();
+
+	for (std::size_t begin = 0; begin < keys_.size();)
+	{
+		std::size_t end = begin + 1;
+		while (end < keys_.size() && (keys_[end].key >> 32) == (keys_[begin].key >> 32))
+			++end;
+
+		draw_state const & state = states_[records_[keys_[begin].index].state];
+		bind(state, gl);
+
+		if (indirect_)
+		{
+			glMultiDrawElementsIndirect(state.mode, state.index_type, (void const *) (begin * sizeof(draw_call)), end - begin, 0);
+		}
+		else
+		{
+			std::size_t const stride = index_type_size(state.index_type);
+			for (std::size_t i = begin; i < end; ++i)
+			{
+				draw_call const & call = commands_[i];
+				void const * offset = (void const *) (call.first_index * stride);
+				if (base_instance_)
+					glDrawElementsInstancedBaseVertexBaseInstance(state.mode, call.count, state.index_type, offset, call.instance_count, call.base_vertex, call.base_instance);
+				else
+					glDrawElementsInstancedBaseVertex(state.mode, call.count, state.index_type, offset, call.instance_count, call.base_vertex);
+			}
+		}
+
+		++last_batches_;
+		begin = end;
+	}
+
+	records_.clear();
+	states_.clear();
+}
+
+void draw_queue::rank_states()
+{
+	state_order_.resize(states_.size());
+	std::iota(state_order_.begin(), state_order_.end(), 0);
+	std::sort(state_order_.begin(), state_order_.end(), [this](std::uint32_t a, std::uint32_t b){
+		return states_[a] < states_[b];
+	});
+
+	state_ranks_.resize(states_.size());
+	for (std::uint32_t rank = 0; rank < state_order_.size(); ++rank)
+		state_ranks_[state_order_[rank]] = rank;
+}
+
+// The buffer is orphaned every frame, so writing it never waits for the
+// draws of the previous one
+void draw_queue::upload_commands()
+{
+	std::size_t size = commands_.size() * sizeof(draw_call);
+	indirect_capacity_ = std::max(indirect_capacity_, size);
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirect_buffer_);
+	glBufferData(GL_DRAW_INDIRECT_BUFFER, indirect_capacity_, nullptr, GL_STREAM_DRAW);
+	glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, size, commands_.data());
+}
+
+void draw_queue::bind(draw_state const & state, gl_state & gl) const
+{
+	gl.use_program(state.program);
+	gl.bind_vertex_array(state.vertex_array);
+	for (std::size_t unit = 0; unit < state.textures.size(); ++unit)
+		if (state.textures[unit] != 0)
+			gl.bind_texture(unit, state.texture_target, state.textures[unit]);
+	gl.set(GL_DEPTH_TEST, state.depth_test);
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "gl_object.h"
+#include "gl_state.h"
+#include "radix_sort.h"
+
+// Everything a draw needs bound. Draws with equal states are batched.
+struct draw_state
+{
+	static constexpr std::size_t max_textures = 4;
+
+	GLuint program = 0;
+	GLuint vertex_array = 0;
+	// Texture unit i gets textures[i]; units with 0 are left alone
+	GLenum texture_target = GL_TEXTURE_2D;
+	std::array<GLuint, max_textures> textures{};
+	bool depth_test = true;
+	GLenum mode = GL_TRIANGLES;
+	GLenum index_type = GL_UNSIGNED_INT;
+
+	friend bool operator == (draw_state const &, draw_state const &) = default;
+	friend auto operator <=> (draw_state const &, draw_state const &) = default;
+};
+
+// Same fields and order as DrawElementsIndirectCommand, so that commands
+// can be copied into the indirect buffer as they are
+struct draw_call
+{
+	GLuint count;
+	GLuint instance_count = 1;
+	GLuint first_index = 0;
+	GLint base_vertex = 0;
+	GLuint base_instance = 0;
+};
+
+// Records draws for a frame and submits them sorted by state, so that each
+// program, vertex array and texture set is bound once per flush. Within a
+// state, draws go front to back by their depth, which lets early depth
+// testing reject hidden fragments.
+//
+// Sorting uses a 64-bit key per draw: the rank of its state (among the
+// distinct states of the flush, in draw_state order) above the depth. The
+// keys are radix-sorted, which stays linear for any number of draws.
+//
+// Every run of draws with the same state becomes a single
+// glMultiDrawElementsIndirect call when GL 4.3 or ARB_multi_draw_indirect is
+// available, and a loop of glDrawElementsInstancedBaseVertex(BaseInstance)
+// otherwise. Nonzero base instances require GL 4.2 or ARB_base_instance;
+// they are how per-draw data (e.g. a per-instance transform attribute)
+// stays addressable in a merged call.
+class draw_queue
+{
+public:
+	draw_queue();
+
+	draw_queue(draw_queue const &) = delete;
+	draw_queue & operator = (draw_queue const &) = delete;
+
+	// `depth` is any value that grows away from the camera, e.g. the
+	// view-space distance of the object
+	void submit(draw_state const & state, draw_call const & call, float depth = 0.f);
+
+	// Issues and clears everything submitted since the last flush
+	void flush(gl_state & state);
+
+	bool indirect() const { return indirect_; }
+	bool base_instance() const { return base_instance_; }
+
+	// Statistics of the last flush
+	std::size_t draws() const { return last_draws_; }
+	std::size_t batches() const { return last_batches_; }
+
+private:
+	struct record
+	{
+		std::uint32_t state;
+		std::uint32_t depth;
+		draw_call call;
+	};
+
+	bool indirect_;
+	bool base_instance_;
+
+	// Distinct states of the current frame; frames rarely have more than a
+	// few dozen, so a linear search beats hashing the whole struct
+	std::vector<draw_state> states_;
+	std::vector<record> records_;
+
+	// Kept between frames so that flushing doesn't allocate
+	std::vector<std::uint32_t> state_order_;
+	std::vector<std::uint32_t> state_ranks_;
+	std::vector<sort_entry> keys_;
+	std::vector<sort_entry> scratch_;
+	std::vector<draw_call> commands_;
+
+	gl_buffer indirect_buffer_;
+	std::size_t indirect_capacity_ = 0;
+
+	std::size_t last_draws_ = 0;
+	std::size_t last_batches_ = 0;
+
+	void rank_states();
+	void upload_commands();
+	void bind(draw_state const & state, gl_state & gl) const;
+};
@@ -0,0 +1,24 @@
+#include "error.h"
+
+#ifdef WIN32
+#include <SDL.h>
+#else
+#include <SDL2/SDL.h>
+#endif
+
+#include <stdexcept>
+
+std::string to_string(std::string_view str)
+{
+	return std::string(str.begin(), str.end());
+}
+
+void sdl2_fail(std::string_view message)
+{
+	throw std::runtime_error(to_string(message) + SDL_GetError());
+}
+
+void glew_fail(std::string_view message, GLenum error)
+{
+	throw std::runtime_error(to_string(message) + reinterpret_cast<const char *>(glewGetErrorString(error)));
+}
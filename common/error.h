@@ -0,0 +1,12 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <string>
+#include <string_view>
+
+std::string to_string(std::string_view str);
+
+// Throw std::runtime_error with `message` followed by the library's own error description
+[[noreturn]] void sdl2_fail(std::string_view message);
+[[noreturn]] void glew_fail(std::string_view message, GLenum error);
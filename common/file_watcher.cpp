@@ -0,0 +1,314 @@
+#include "file_watcher.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+#include <utility>
+
+#ifdef WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#else
+#include <chrono>
+#endif
+
+struct file_watcher::directory
+{
+	std::filesystem::path path;
+	// File names inside the directory and how they were passed to watch()
+	std::vector<std::pair<std::string, std::string>> files;
+
+#ifdef WIN32
+	HANDLE handle = INVALID_HANDLE_VALUE;
+	OVERLAPPED overlapped{};
+	alignas(DWORD) char buffer[16384];
+
+	bool listen()
+	{
+		return ReadDirectoryChangesW(handle, buffer, sizeof(buffer), FALSE,
+			FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME, nullptr, &overlapped, nullptr);
+	}
+
+	~directory()
+	{
+		if (handle != INVALID_HANDLE_VALUE)
+		{
+			CancelIo(handle);
+			CloseHandle(handle);
+		}
+		if (overlapped.hEvent)
+			CloseHandle(overlapped.hEvent);
+	}
+#elif defined(__linux__)
+	int descriptor = -1;
+#else
+	std::vector<std::filesystem::file_time_type> times;
+#endif
+};
+
+Uint32 file_watcher::event_type()
+{
+	static Uint32 const type = SDL_RegisterEvents(1);
+	return type;
+}
+
+file_watcher::file_watcher()
+{
+#ifdef WIN32
+	stop_event_ = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+	rescan_event_ = CreateEventA(nullptr, FALSE, FALSE, nullptr);
+	if (!stop_event_ || !rescan_event_)
+	{
+		if (stop_event_)
+			CloseHandle(stop_event_);
+		if (rescan_event_)
+			CloseHandle(rescan_event_);
+		throw std::runtime_error("Failed to create the file watcher events");
+	}
+#elif defined(__linux__)
+	inotify_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	stop_fd_ = eventfd(0, EFD_CLOEXEC);
+	if (inotify_ < 0 || stop_fd_ < 0)
+	{
+		if (inotify_ >= 0)
+			::close(inotify_);
+		if (stop_fd_ >= 0)
+			::close(stop_fd_);
+		throw std::runtime_error(std::string("Failed to initialize inotify: ") + std::strerror(errno));
+	}
+#endif
+
+	// Registered here, not lazily on the watcher thread
+	event_type();
+	thread_ = std::thread([this]{ run(); });
+}
+
+file_watcher::~file_watcher()
+{
+#ifdef WIN32
+	SetEvent(stop_event_);
+	thread_.join();
+	directories_.clear();
+	CloseHandle(stop_event_);
+	CloseHandle(rescan_event_);
+#elif defined(__linux__)
+	std::uint64_t const one = 1;
+	[[maybe_unused]] auto written = ::write(stop_fd_, &one, sizeof(one));
+	thread_.join();
+	::close(inotify_);
+	::close(stop_fd_);
+#else
+	{
+		std::lock_guard lock(mutex_);
+		stop_ = true;
+	}
+	stop_cv_.notify_all();
+	thread_.join();
+#endif
+}
+
+void file_watcher::watch(std::string const & path)
+{
+	std::filesystem::path const absolute = std::filesystem::absolute(path);
+	std::filesystem::path const parent = absolute.parent_path();
+	std::string const name = absolute.filename().string();
+
+	std::lock_guard lock(mutex_);
+
+	auto it = std::find_if(directories_.begin(), directories_.end(), [&](auto const & d){ return d->path == parent; });
+	if (it == directories_.end())
+	{
+		auto dir = std::make_unique<directory>();
+		dir->path = parent;
+
+#ifdef WIN32
+		dir->handle = CreateFileW(parent.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+			nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+		dir->overlapped.hEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+		if (dir->handle == INVALID_HANDLE_VALUE || !dir->overlapped.hEvent || !dir->listen())
+			throw std::runtime_error("Failed to watch " + parent.string());
+#elif defined(__linux__)
+		dir->descriptor = inotify_add_watch(inotify_, parent.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+		if (dir->descriptor < 0)
+			throw std::runtime_error("Failed to watch " + parent.string() + ": " + std::strerror(errno));
+#endif
+
+		directories_.push_back(std::move(dir));
+		it = directories_.end() - 1;
+
+#ifdef WIN32
+		SetEvent(rescan_event_);
+#endif
+	}
+
+	auto & files = (*it)->files;
+	if (std::find(files.begin(), files.end(), std::pair(name, path)) != files.end())
+		return;
+	files.emplace_back(name, path);
+
+#if !defined(WIN32) && !defined(__linux__)
+	std::error_code error;
+	(*it)->times.push_back(std::filesystem::last_write_time(absolute, error));
+#endif
+}
+
+std::vector<std::string> file_watcher::changes()
+{
+	std::lock_guard lock(mutex_);
+	return std::exchange(changes_, {});
+}
+
+void file_watcher::record(directory const & dir, std::string const & name)
+{
+	for (auto const & [file, path] : dir.files)
+	{
+		if (file == name && std::find(changes_.begin(), changes_.end(), path) == changes_.end())
+			changes_.push_back(path);
+	}
+}
+
+void file_watcher::notify()
+{
+	SDL_Event event{};
+	event.type = event_type();
+	SDL_PushEvent(&event);
+}
+
+#ifdef WIN32
+
+void file_watcher::run()
+{
+	while (true)
+	{
+		std::vector<HANDLE> handles{stop_event_, rescan_event_};
+		{
+			std::lock_guard lock(mutex_);
+			for (auto const & dir : directories_)
+				handles.push_back(dir->overlapped.hEvent);
+		}
+
+		DWORD const result = WaitForMultipleObjects(DWORD(handles.size()), handles.data(), FALSE, INFINITE);
+		if (result == WAIT_OBJECT_0 || result == WAIT_FAILED)
+			return;
+		if (result == WAIT_OBJECT_0 + 1)
+			continue;
+
+		bool changed = false;
+		{
+			std::lock_guard lock(mutex_);
+			auto & dir = *directories_[result - WAIT_OBJECT_0 - 2];
+
+			DWORD size = 0;
+			if (GetOverlappedResult(dir.handle, &dir.overlapped, &size, FALSE) && size > 0)
+			{
+				for (char const * entry = dir.buffer;;)
+				{
+					auto const & info = *reinterpret_cast<FILE_NOTIFY_INFORMATION const *>(entry);
+					if (info.Action == FILE_ACTION_ADDED || info.Action == FILE_ACTION_MODIFIED || info.Action == FILE_ACTION_RENAMED_NEW_NAME)
+					{
+						std::wstring const name(info.FileName, info.FileNameLength / sizeof(WCHAR));
+						std::size_t const before = changes_.size();
+						record(dir, std::filesystem::path(name).string());
+						changed |= changes_.size() != before;
+					}
+					if (info.NextEntryOffset == 0)
+						break;
+					entry += info.NextEntryOffset;
+				}
+			}
+
+			ResetEvent(dir.overlapped.hEvent);
+			dir.listen();
+		}
+
+		if (changed)
+			notify();
+	}
+}
+
+#elif defined(__linux__)
+
+void file_watcher::run()
+{
+	pollfd fds[2] = {{inotify_, POLLIN, 0}, {stop_fd_, POLLIN, 0}};
+	alignas(inotify_event) char buffer[4096];
+
+	while (true)
+	{
+		if (::poll(fds, 2, -1) < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			return;
+		}
+		if (fds[1].revents)
+			return;
+
+		bool changed = false;
+		for (ssize_t size; (size = ::read(inotify_, buffer, sizeof(buffer))) > 0;)
+		{
+			std::lock_guard lock(mutex_);
+			for (char const * entry = buffer; entry < buffer + size;)
+			{
+				auto const & event = *reinterpret_cast<inotify_event const *>(entry);
+				entry += sizeof(inotify_event) + event.len;
+				if (event.len == 0)
+					continue;
+
+				auto it = std::find_if(directories_.begin(), directories_.end(), [&](auto const & d){ return d->descriptor == event.wd; });
+				if (it == directories_.end())
+					continue;
+
+				std::size_t const before = changes_.size();
+				record(**it, event.name);
+				changed |= changes_.size() != before;
+			}
+		}
+
+		if (changed)
+			notify();
+	}
+}
+
+#else
+
+void file_watcher::run()
+{
+	std::unique_lock lock(mutex_);
+	while (!stop_cv_.wait_for(lock, std::chrono::milliseconds(250), [this]{ return stop_; }))
+	{
+		bool changed = false;
+		for (auto & dir : directories_)
+		{
+			for (std::size_t i = 0; i < dir->files.size(); ++i)
+			{
+				std::error_code error;
+				auto const time = std::filesystem::last_write_time(dir->path / dir->files[i].first, error);
+				if (error || time == dir->times[i])
+					continue;
+
+				dir->times[i] = time;
+				std::size_t const before = changes_.size();
+				record(*dir, dir->files[i].first);
+				changed |= changes_.size() != before;
+			}
+		}
+
+		if (changed)
+		{
+			lock.unlock();
+			notify();
+			lock.lock();
+		}
+	}
+}
+
+#endif
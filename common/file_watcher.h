@@ -0,0 +1,67 @@
+#pragma once
+
+#ifdef WIN32
+#include <SDL.h>
+#else
+#include <SDL2/SDL.h>
+#endif
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Reports changes of individual files, noticed by a background thread that
+// observes their directories: with inotify on Linux, ReadDirectoryChangesW
+// on Windows, and by polling modification times four times a second
+// elsewhere. Watching the directory instead of the file also catches files
+// replaced by a rename, which is how most editors save.
+//
+// Every batch of changes pushes an event of event_type() to the SDL queue,
+// so that a loop sleeping in SDL_WaitEvent wakes up to handle it.
+class file_watcher
+{
+public:
+	file_watcher();
+	~file_watcher();
+
+	file_watcher(file_watcher const &) = delete;
+	file_watcher & operator = (file_watcher const &) = delete;
+
+	// The directory must exist, the file itself may not yet
+	void watch(std::string const & path);
+
+	// Files that changed since the last call, each once and spelled as
+	// they were passed to watch()
+	std::vector<std::string> changes();
+
+	static Uint32 event_type();
+
+private:
+	struct directory;
+
+	std::mutex mutex_;
+	std::vector<std::unique_ptr<directory>> directories_;
+	std::vector<std::string> changes_;
+	std::thread thread_;
+
+#ifdef WIN32
+	void * stop_event_ = nullptr;
+	// Signalled when a directory is added, so that the thread waits on it too
+	void * rescan_event_ = nullptr;
+#elif defined(__linux__)
+	int inotify_ = -1;
+	int stop_fd_ = -1;
+#else
+	bool stop_ = false;
+	std::condition_variable stop_cv_;
+#endif
+
+	void run();
+	// With mutex_ held
+	void record(directory const & dir, std::string const & name);
+	void notify();
+};
@@ -0,0 +1,31 @@
+#include "frame_fences.h"
+
+#include <algorithm>
+
+frame_fences::frame_fences(std::size_t frames_in_flight)
+	: fences_(std::max<std::size_t>(frames_in_flight, 1), nullptr)
+{}
+
+frame_fences::~frame_fences()
+{
+	for (GLsync fence : fences_)
+		if (fence)
+			glDeleteSync(fence);
+}
+
+void frame_fences::begin_frame()
+{
+	if (GLsync & fence = fences_[next_])
+	{
+		while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64(1000000000)) == GL_TIMEOUT_EXPIRED)
+			;
+		glDeleteSync(fence);
+		fence = nullptr;
+	}
+}
+
+void frame_fences::end_frame()
+{
+	fences_[next_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	next_ = (next_ + 1) % fences_.size();
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <vector>
+
+// Bounds how far the CPU may run ahead of the GPU: end_frame() puts a fence
+// after the commands of a frame, and begin_frame() waits until the fence of
+// the frame `frames_in_flight` frames back has been passed. Without it, the
+// driver may queue up several frames and add their latency to the input.
+class frame_fences
+{
+public:
+	explicit frame_fences(std::size_t frames_in_flight = 2);
+	~frame_fences();
+
+	frame_fences(frame_fences const &) = delete;
+	frame_fences & operator = (frame_fences const &) = delete;
+
+	std::size_t frames_in_flight() const { return fences_.size(); }
+
+	void begin_frame();
+	void end_frame();
+
+private:
+	std::vector<GLsync> fences_;
+	std::size_t next_ = 0;
+};
@@ -0,0 +1,115 @@
+#include "frame_pacer.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+frame_pacer::frame_pacer(pacing_options const & options, redraw_mode default_redraw)
+	: mode_(options.mode)
+	, redraw_(options.redraw.value_or(default_redraw))
+{
+	int interval = 1;
+	switch (mode_)
+	{
+	case pacing_mode::vsync:
+		break;
+	case pacing_mode::adaptive:
+		interval = -1;
+		break;
+	case pacing_mode::uncapped:
+		interval = 0;
+		break;
+	case pacing_mode::limited:
+		if (!(options.target_fps > 0.0))
+			throw std::runtime_error("The target frame rate must be positive");
+		interval = 0;
+		period_ = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / options.target_fps));
+		break;
+	}
+
+	if (SDL_GL_SetSwapInterval(interval) != 0)
+	{
+		// Adaptive vsync needs EXT_swap_control_tear or its WGL equivalent
+		if (interval == -1 && SDL_GL_SetSwapInterval(1) == 0)
+			mode_ = pacing_mode::vsync;
+	}
+
+	if (options.frames_in_flight > 0)
+		fences_ = std::make_unique<frame_fences>(options.frames_in_flight);
+}
+
+void frame_pacer::invalidate()
+{
+	dirty_ = true;
+}
+
+void frame_pacer::invalidate_after(clock::duration delay)
+{
+	auto const when = clock::now() + delay;
+	if (!scheduled_ || when < *scheduled_)
+		scheduled_ = when;
+}
+
+void frame_pacer::begin_frame()
+{
+	if (redraw_ == redraw_mode::on_demand)
+		wait_for_invalidation();
+	if (mode_ == pacing_mode::limited)
+		wait_for_deadline();
+	if (fences_)
+		fences_->begin_frame();
+}
+
+void frame_pacer::present(SDL_Window * window)
+{
+	SDL_GL_SwapWindow(window);
+	if (fences_)
+		fences_->end_frame();
+}
+
+void frame_pacer::wait_for_deadline()
+{
+	auto now = clock::now();
+
+	// After a long frame (or the first one) the schedule restarts from now
+	// instead of rushing through the missed slots
+	if (now - deadline_ > period_)
+		deadline_ = now;
+
+	if (deadline_ - now > sleep_margin_)
+	{
+		auto const wake = deadline_ - sleep_margin_;
+		std::this_thread::sleep_until(wake);
+		auto const overshoot = clock::now() - wake;
+		sleep_margin_ = std::max({overshoot, sleep_margin_ * 15 / 16, clock::duration(std::chrono::microseconds(250))});
+	}
+
+	while (clock::now() < deadline_)
+		std::this_thread::yield();
+
+	deadline_ += period_;
+}
+
+void frame_pacer::wait_for_invalidation()
+{
+	while (!dirty_)
+	{
+		int timeout = -1;
+		if (scheduled_)
+		{
+			auto const left = *scheduled_ - clock::now();
+			if (left <= clock::duration::zero())
+				break;
+			// Rounded up, so that the wait never ends just before the deadline
+			timeout = int(std::chrono::ceil<std::chrono::milliseconds>(left).count());
+		}
+
+		// With a null event, SDL only waits and leaves the event queued
+		if (timeout < 0 ? SDL_WaitEvent(nullptr) : SDL_WaitEventTimeout(nullptr, timeout))
+			dirty_ = true;
+	}
+
+	dirty_ = false;
+	if (scheduled_ && *scheduled_ <= clock::now())
+		scheduled_.reset();
+}
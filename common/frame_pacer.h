@@ -0,0 +1,101 @@
+#pragma once
+
+#ifdef WIN32
+#include <SDL.h>
+#else
+#include <SDL2/SDL.h>
+#endif
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <optional>
+
+#include "frame_fences.h"
+
+enum class pacing_mode
+{
+	// Swap interval 1: one frame per display refresh, the least power
+	vsync,
+	// Swap interval -1: like vsync, but a frame that missed its refresh is
+	// shown right away instead of waiting for the next one (tears instead
+	// of stuttering). Falls back to vsync where unsupported.
+	adaptive,
+	// Swap interval 0: as many frames as the GPU manages, the lowest latency
+	uncapped,
+	// Swap interval 0, and the CPU waits to start each frame on a fixed
+	// schedule of `target_fps`
+	limited,
+};
+
+enum class redraw_mode
+{
+	// A new frame as soon as pacing allows, whether anything changed or not
+	continuous,
+	// Frames only after an invalidation: any SDL event (input, resize,
+	// expose), an explicit invalidate(), or a scheduled animation step. In
+	// between, the thread sleeps in SDL_WaitEventTimeout.
+	on_demand,
+};
+
+struct pacing_options
+{
+	pacing_mode mode = pacing_mode::vsync;
+	// Unset leaves the choice to the target
+	std::optional<redraw_mode> redraw;
+	double target_fps = 60.0;
+	// At most this many frames are queued on the GPU; 0 leaves it to the
+	// driver, whose queue may add several frames of latency
+	std::size_t frames_in_flight = 2;
+};
+
+// Decides when windowed frames start and are presented. begin_frame() is
+// called at the top of the frame loop, before input is read, and blocks
+// until the frame may start: until its slot in the schedule of the limited
+// mode, and until the GPU has finished the frame `frames_in_flight` frames
+// back. present() swaps the window and fences the frame.
+//
+// The limiter sleeps until shortly before the deadline and spins for the
+// rest, as OS sleeps overshoot by up to a scheduler tick; the margin
+// adapts to the largest recent overshoot.
+//
+// In the on-demand redraw mode, begin_frame() first waits for an
+// invalidation. Events are left in the queue for the caller to poll.
+class frame_pacer
+{
+public:
+	using clock = std::chrono::steady_clock;
+
+	// Sets the swap interval of the current context. `default_redraw` is
+	// used unless the options choose a redraw mode.
+	explicit frame_pacer(pacing_options const & options, redraw_mode default_redraw = redraw_mode::continuous);
+
+	frame_pacer(frame_pacer const &) = delete;
+	frame_pacer & operator = (frame_pacer const &) = delete;
+
+	// After a possible fallback from adaptive to vsync
+	pacing_mode mode() const { return mode_; }
+	redraw_mode redraw() const { return redraw_; }
+
+	// Both do nothing in the continuous mode. A scheduled redraw replaces
+	// a later one; one that is already due stays due.
+	void invalidate();
+	void invalidate_after(clock::duration delay);
+
+	void begin_frame();
+	void present(SDL_Window * window);
+
+private:
+	pacing_mode mode_;
+	redraw_mode redraw_;
+	// The first frame is always drawn
+	bool dirty_ = true;
+	std::optional<clock::time_point> scheduled_;
+	clock::duration period_{};
+	clock::time_point deadline_{};
+	clock::duration sleep_margin_ = std::chrono::milliseconds(1);
+	std::unique_ptr<frame_fences> fences_;
+
+	void wait_for_deadline();
+	void wait_for_invalidation();
+};
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <utility>
+
+// Owning, move-only handle of a GL object name. `Traits` provides
+// `create()` (for default construction) and `destroy(GLuint)`. Converts
+// implicitly to the name, so it can be passed to GL functions directly.
+// All handles must be destroyed while the context is still current.
+template <typename Traits>
+class gl_object
+{
+public:
+	gl_object()
+		: id_(Traits::create())
+	{}
+
+	// Takes ownership of an existing name
+	explicit gl_object(GLuint id)
+		: id_(id)
+	{}
+
+	~gl_object()
+	{
+		reset();
+	}
+
+	gl_object(gl_object && other)
+		: id_(std::exchange(other.id_, 0))
+	{}
+
+	gl_object & operator = (gl_object && other)
+	{
+		if (this != &other)
+		{
+			reset();
+			id_ = std::exchange(other.id_, 0);
+		}
+		return *this;
+	}
+
+	gl_object(gl_object const &) = delete;
+	gl_object & operator = (gl_object const &) = delete;
+
+	GLuint id() const { return id_; }
+	operator GLuint() const { return id_; }
+
+	// Gives up ownership without deleting the object
+	GLuint release()
+	{
+		return std::exchange(id_, 0);
+	}
+
+	void reset()
+	{
+		if (id_ != 0)
+			Traits::destroy(id_);
+		id_ = 0;
+	}
+
+private:
+	GLuint id_;
+};
+
+struct gl_buffer_traits
+{
+	static GLuint create() { GLuint id; glGenBuffers(1, &id); return id; }
+	static void destroy(GLuint id) { glDeleteBuffers(1, &id); }
+};
+
+struct gl_vertex_array_traits
+{
+	static GLuint create() { GLuint id; glGenVertexArrays(1, &id); return id; }
+	static void destroy(GLuint id) { glDeleteVertexArrays(1, &id); }
+};
+
+struct gl_texture_traits
+{
+	static GLuint create() { GLuint id; glGenTextures(1, &id); return id; }
+	static void destroy(GLuint id) { glDeleteTextures(1, &id); }
+};
+
+struct gl_framebuffer_traits
+{
+	static GLuint create() { GLuint id; glGenFramebuffers(1, &id); return id; }
+	static void destroy(GLuint id) { glDeleteFramebuffers(1, &id); }
+};
+
+struct gl_renderbuffer_traits
+{
+	static GLuint create() { GLuint id; glGenRenderbuffers(1, &id); return id; }
+	static void destroy(GLuint id) { glDeleteRenderbuffers(1, &id); }
+};
+
+struct gl_shader_traits
+{
+	// Shaders need a type, so they can only be constructed from an existing name
+	static void destroy(GLuint id) { glDeleteShader(id); }
+};
+
+using gl_buffer = gl_object<gl_buffer_traits>;
+using gl_vertex_array = gl_object<gl_vertex_array_traits>;
+using gl_texture = gl_object<gl_texture_traits>;
+using gl_framebuffer = gl_object<gl_framebuffer_traits>;
+using gl_renderbuffer = gl_object<gl_renderbuffer_traits>;
+using gl_shader = gl_object<gl_shader_traits>;
@@ -0,0 +1,139 @@
+#include "gl_state.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <ostream>
+
+namespace
+{
+
+void print_counters(std::ostream & out, char const * label, gl_state_counters const & counters)
+{
+	std::uint64_t total = counters.issued + counters.filtered;
+	char buffer[160];
+	std::snprintf(buffer, sizeof(buffer), "  %-16s issued %10llu  filtered %10llu  (%5.1f%%)\n",
+		label, (unsigned long long)counters.issued, (unsigned long long)counters.filtered,
+		total > 0 ? 100.0 * counters.filtered / total : 0.0);
+	out << buffer;
+}
+
+}
+
+gl_state::gl_state()
+{
+	GLint unit_count = 0;
+	glGetIntegerv(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS, &unit_count);
+	units_.resize(std::max(unit_count, 1));
+	invalidate();
+}
+
+void gl_state::use_program(GLuint program)
+{
+	if (program == program_)
+	{
+		++programs_.filtered;
+		return;
+	}
+	glUseProgram(program);
+	program_ = program;
+	++programs_.issued;
+}
+
+void gl_state::bind_vertex_array(GLuint vao)
+{
+	if (vao == vertex_array_)
+	{
+		++vertex_arrays_.filtered;
+		return;
+	}
+	glBindVertexArray(vao);
+	vertex_array_ = vao;
+	++vertex_arrays_.issued;
+}
+
+void gl_state::bind_texture(GLuint unit, GLenum target, GLuint texture)
+{
+	auto target_it = std::find(texture_targets.begin(), texture_targets.end(), target);
+	bool cached = target_it != texture_targets.end() && unit < units_.size();
+
+	// The unit selection is counted as a call of its own, the way a
+	// straightforward glActiveTexture + glBindTexture sequence would issue it
+	GLuint * binding = cached ? &units_[unit][target_it - texture_targets.begin()] : nullptr;
+	if (binding && *binding == texture)
+	{
+		textures_.filtered += 2;
+		return;
+	}
+
+	active_texture(unit);
+	glBindTexture(target, texture);
+	if (binding)
+		*binding = texture;
+	++textures_.issued;
+}
+
+void gl_state::active_texture(GLuint unit)
+{
+	if (unit == active_unit_)
+	{
+		++textures_.filtered;
+		return;
+	}
+	glActiveTexture(GL_TEXTURE0 + unit);
+	active_unit_ = unit;
+	++textures_.issued;
+}
+
+void gl_state::enable(GLenum capability)
+{
+	set(capability, true);
+}
+
+void gl_state::disable(GLenum capability)
+{
+	set(capability, false);
+}
+
+void gl_state::set(GLenum capability, bool enabled)
+{
+	auto it = std::find_if(capability_states_.begin(), capability_states_.end(), [capability](auto const & entry){
+		return entry.first == capability;
+	});
+	if (it == capability_states_.end())
+		it = capability_states_.insert(it, {capability, tristate::unknown});
+
+	tristate state = enabled ? tristate::enabled : tristate::disabled;
+	if (it->second == state)
+	{
+		++capabilities_.filtered;
+		return;
+	}
+
+	if (enabled)
+		glEnable(capability);
+	else
+		glDisable(capability);
+	it->second = state;
+	++capabilities_.issued;
+}
+
+void gl_state::invalidate()
+{
+	program_ = unknown;
+	vertex_array_ = unknown;
+	active_unit_ = unknown;
+	for (auto & unit : units_)
+		unit.fill(unknown);
+	for (auto & entry : capability_states_)
+		entry.second = tristate::unknown;
+}
+
+void gl_state::report(std::ostream & out) const
+{
+	out << "state changes:\n";
+	print_counters(out, "programs", programs_);
+	print_counters(out, "vertex arrays", vertex_arrays_);
+	print_counters(out, "textures", textures_);
+	print_counters(out, "capabilities", capabilities_);
+	out.flush();
+}
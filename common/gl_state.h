@@ -0,0 +1,91 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <array>
+#include <cstdint>
+#include <iosfwd>
+#include <utility>
+#include <vector>
+
+// Number of GL calls that reached the driver vs. were dropped as redundant
+struct gl_state_counters
+{
+	std::uint64_t issued = 0;
+	std::uint64_t filtered = 0;
+};
+
+// Shadow copy of the context state that the render loops change every
+// frame. Each setter compares against the last value it set and only calls
+// into GL when something actually changes, which saves the driver the
+// validation work for redundant binds and enables.
+//
+// Nothing is known about the context at construction, so the first call
+// for every piece of state is always issued. Code that changes the same
+// state behind the cache's back (or deletes an object that is currently
+// bound, after which GL silently binds 0) must call invalidate().
+class gl_state
+{
+public:
+	gl_state();
+
+	void use_program(GLuint program);
+	void bind_vertex_array(GLuint vao);
+
+	// Binds `texture` to `target` of texture unit `unit` (0-based);
+	// glActiveTexture is only issued when the binding has to change
+	void bind_texture(GLuint unit, GLenum target, GLuint texture);
+
+	// Makes `unit` the active one, e.g. before glTexSubImage* on a texture
+	// bound with bind_texture(), which may have left another unit active
+	void active_texture(GLuint unit);
+
+	void enable(GLenum capability);
+	void disable(GLenum capability);
+	void set(GLenum capability, bool enabled);
+
+	// Forgets everything, so that the next call of every setter is issued
+	void invalidate();
+
+	gl_state_counters programs() const { return programs_; }
+	gl_state_counters vertex_arrays() const { return vertex_arrays_; }
+	gl_state_counters textures() const { return textures_; }
+	gl_state_counters capabilities() const { return capabilities_; }
+
+	// Prints the counters accumulated since construction
+	void report(std::ostream & out) const;
+
+private:
+	static constexpr GLuint unknown = ~GLuint(0);
+
+	// Texture targets with a cached binding; other targets are passed through
+	static constexpr std::array<GLenum, 5> texture_targets
+	{
+		GL_TEXTURE_2D,
+		GL_TEXTURE_2D_ARRAY,
+		GL_TEXTURE_3D,
+		GL_TEXTURE_CUBE_MAP,
+		GL_TEXTURE_BUFFER,
+	};
+
+	using unit_bindings = std::array<GLuint, texture_targets.size()>;
+
+	enum class tristate : std::uint8_t
+	{
+		unknown,
+		disabled,
+		enabled,
+	};
+
+	GLuint program_;
+	GLuint vertex_array_;
+	GLuint active_unit_;
+	std::vector<unit_bindings> units_;
+	// Linear search is cheaper than anything else for a handful of capabilities
+	std::vector<std::pair<GLenum, tristate>> capability_states_;
+
+	gl_state_counters programs_;
+	gl_state_counters vertex_arrays_;
+	gl_state_counters textures_;
+	gl_state_counters capabilities_;
+};
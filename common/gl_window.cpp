@@ -0,0 +1,68 @@
+#include "gl_window.h"
+#include "error.h"
+
+#include <stdexcept>
+
+gl_window::gl_window(char const * title, Uint32 flags, gl_window_config const & config)
+{
+	if (SDL_Init(SDL_INIT_VIDEO) != 0)
+		sdl2_fail("SDL_Init: ");
+
+	try
+	{
+		SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+		SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+		SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+		SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
+		SDL_GL_SetAttribute(SDL_GL_RED_SIZE, 8);
+		SDL_GL_SetAttribute(SDL_GL_GREEN_SIZE, 8);
+		SDL_GL_SetAttribute(SDL_GL_BLUE_SIZE, 8);
+		if (config.samples > 0)
+		{
+			SDL_GL_SetAttribute(SDL_GL_MULTISAMPLEBUFFERS, 1);
+			SDL_GL_SetAttribute(SDL_GL_MULTISAMPLESAMPLES, config.samples);
+		}
+		if (config.depth_size > 0)
+			SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, config.depth_size);
+
+		window_ = SDL_CreateWindow(title,
+			SDL_WINDOWPOS_CENTERED,
+			SDL_WINDOWPOS_CENTERED,
+			800, 600,
+			flags | SDL_WINDOW_OPENGL);
+
+		if (!window_)
+			sdl2_fail("SDL_CreateWindow: ");
+
+		SDL_GetWindowSize(window_, &width_, &height_);
+
+		context_ = SDL_GL_CreateContext(window_);
+		if (!context_)
+			sdl2_fail("SDL_GL_CreateContext: ");
+
+		if (auto result = glewInit(); result != GLEW_NO_ERROR)
+			glew_fail("glewInit: ", result);
+
+		if (!GLEW_VERSION_3_3)
+			throw std::runtime_error("OpenGL 3.3 is not supported");
+	}
+	catch (...)
+	{
+		destroy();
+		throw;
+	}
+}
+
+gl_window::~gl_window()
+{
+	destroy();
+}
+
+void gl_window::destroy()
+{
+	if (context_)
+		SDL_GL_DeleteContext(context_);
+	if (window_)
+		SDL_DestroyWindow(window_);
+	SDL_Quit();
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#ifdef WIN32
+#include <SDL.h>
+#else
+#include <SDL2/SDL.h>
+#endif
+
+#include <GL/glew.h>
+
+struct gl_window_config
+{
+	// 0 disables multisampling
+	int samples = 0;
+	// 0 means no depth buffer
+	int depth_size = 0;
+};
+
+// Initializes SDL, creates a window with an OpenGL 3.3 core context and
+// loads the GL functions through GLEW; tears everything down in reverse
+// order on destruction. Construct it before any GL object, so that those
+// are destroyed while the context is still alive.
+class gl_window
+{
+public:
+	gl_window(char const * title, Uint32 flags, gl_window_config const & config = {});
+	~gl_window();
+
+	gl_window(gl_window const &) = delete;
+	gl_window & operator = (gl_window const &) = delete;
+
+	SDL_Window * get() const { return window_; }
+	operator SDL_Window * () const { return window_; }
+
+	// Size right after creation; resizes are reported through SDL events
+	int width() const { return width_; }
+	int height() const { return height_; }
+
+private:
+	SDL_Window * window_ = nullptr;
+	SDL_GLContext context_ = nullptr;
+	int width_ = 0;
+	int height_ = 0;
+
+	void destroy();
+};
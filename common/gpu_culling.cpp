@@ -0,0 +1,132 @@
+#include "gpu_culling.h"
+
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+
+const char cull_shader_source[] =
+R"(#version 430 core
+
+layout (local_size_x = 64) in;
+
+struct draw_command
+{
+	uint count;
+	uint instance_count;
+	uint first_index;
+	int base_vertex;
+	uint base_instance;
+};
+
+// Center and extent of every object
+layout (std430, binding = 0) readonly buffer bounds_buffer { vec4 bounds[]; };
+layout (std430, binding = 1) readonly buffer source_buffer { vec4 source[]; };
+layout (std430, binding = 2) writeonly buffer instance_buffer { vec4 instances[]; };
+layout (std430, binding = 3) buffer command_buffer { draw_command command; };
+
+uniform vec4 planes[6];
+uniform uint object_count;
+uniform uint instance_size;
+
+void main()
+{
+	uint id = gl_GlobalInvocationID.x;
+	if (id >= object_count)
+		return;
+
+	vec3 center = bounds[2 * id].xyz;
+	vec3 extent = bounds[2 * id + 1].xyz;
+	for (int i = 0; i < 6; ++i)
+	{
+		if (dot(planes[i].xyz, center) + planes[i].w + dot(abs(planes[i].xyz), extent) < 0.0)
+			return;
+	}
+
+	uint slot = atomicAdd(command.instance_count, 1u);
+	for (uint i = 0; i < instance_size; ++i)
+		instances[slot * instance_size + i] = source[id * instance_size + i];
+}
+)";
+
+constexpr GLuint local_size = 64;
+
+gl_program create_cull_program()
+{
+	auto shader = create_shader(GL_COMPUTE_SHADER, cull_shader_source);
+	return create_compute_program(shader);
+}
+
+}
+
+bool gpu_culler::supported()
+{
+	return GLEW_VERSION_4_3;
+}
+
+gpu_culler::gpu_culler(std::span<aabb const> bounds)
+	: program_(create_cull_program())
+	, planes_location_(program_.uniform("planes"))
+	, object_count_location_(program_.uniform("object_count"))
+	, instance_size_location_(program_.uniform("instance_size"))
+	, object_count_(bounds.size())
+{
+	std::vector<vec4> data;
+	data.reserve(2 * bounds.size());
+	for (auto const & box : bounds)
+	{
+		vec3 const center = (box.min + box.max) * 0.5f;
+		vec3 const extent = (box.max - box.min) * 0.5f;
+		data.push_back({center.x, center.y, center.z, 0.f});
+		data.push_back({extent.x, extent.y, extent.z, 0.f});
+	}
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, bounds_);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, data.size() * sizeof(vec4), data.data(), GL_STATIC_DRAW);
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, command_);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(draw_call), nullptr, GL_DYNAMIC_DRAW);
+}
+
+void gpu_culler::cull(gl_state & state, frustum const & f, void const * instances, std::size_t count, std::size_t vec4s_per_instance, draw_call const & command)
+{
+	if (count != object_count_)
+		throw std::runtime_error("gpu_culler needs instance data for every object");
+
+	std::size_t const size = count * vec4s_per_instance * sizeof(vec4);
+
+	// Orphaned like any other streamed buffer, the previous frame's draw may
+	// still be reading them
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, source_);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, size, nullptr, GL_STREAM_DRAW);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, size, instances);
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, instances_);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, size, nullptr, GL_STREAM_DRAW);
+
+	draw_call reset = command;
+	reset.instance_count = 0;
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, command_);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(draw_call), &reset, GL_DYNAMIC_DRAW);
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, bounds_);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, source_);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, instances_);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, command_);
+
+	state.use_program(program_);
+	glUniform4fv(planes_location_, 6, &f.planes()[0].x);
+	glUniform1ui(object_count_location_, count);
+	glUniform1ui(instance_size_location_, vec4s_per_instance);
+	glDispatchCompute((count + local_size - 1) / local_size, 1, 1);
+
+	// The command is read by the indirect draw, the instances as attributes
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+}
+
+void gpu_culler::draw(GLenum mode, GLenum index_type) const
+{
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command_);
+	glDrawElementsIndirect(mode, index_type, nullptr);
+}
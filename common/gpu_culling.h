@@ -0,0 +1,59 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <span>
+
+#include "culling.h"
+#include "draw_queue.h"
+#include "gl_object.h"
+#include "gl_state.h"
+#include "shader.h"
+
+// Frustum culling in a compute shader, one invocation per object. Objects
+// that pass append their per-instance data to instances() and increment the
+// instance count of a DrawElementsIndirectCommand, which draw() then
+// submits; the CPU never sees the number of survivors, so nothing waits for
+// the GPU. Survivors end up in no particular order.
+//
+// Like cull_grid, the bounds are static; the instance data is uploaded
+// anew on every cull. Requires GL 4.3 (compute shaders, shader storage
+// buffers and indirect draws).
+class gpu_culler
+{
+public:
+	static bool supported();
+
+	explicit gpu_culler(std::span<aabb const> bounds);
+
+	// `instances` holds one element per object; its size must be a multiple
+	// of 16 bytes (e.g. a mat4 transform), which is copied as it is.
+	// `command` is drawn with its instance count replaced.
+	template <typename Instance>
+	void cull(gl_state & state, frustum const & f, std::span<Instance const> instances, draw_call const & command)
+	{
+		static_assert(sizeof(Instance) % 16 == 0, "Instance data must be a whole number of vec4s");
+		cull(state, f, instances.data(), instances.size(), sizeof(Instance) / 16, command);
+	}
+
+	// The buffer the surviving instances are written to, for use as a
+	// per-instance vertex attribute source
+	GLuint instances() const { return instances_; }
+
+	// Draws the command of the last cull with the bound vertex array
+	void draw(GLenum mode, GLenum index_type) const;
+
+private:
+	void cull(gl_state & state, frustum const & f, void const * instances, std::size_t count, std::size_t vec4s_per_instance, draw_call const & command);
+
+	gl_program program_;
+	GLint planes_location_;
+	GLint object_count_location_;
+	GLint instance_size_location_;
+	std::size_t object_count_;
+	gl_buffer bounds_;
+	gl_buffer source_;
+	gl_buffer instances_;
+	gl_buffer command_;
+};
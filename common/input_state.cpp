@@ -0,0 +1,54 @@
+#include "input_state.h"
+
+input_state::input_state()
+	: keys_(SDL_GetKeyboardState(nullptr))
+{
+	mouse_down_ = SDL_GetMouseState(&mouse_x_, &mouse_y_);
+}
+
+void input_state::begin_frame()
+{
+	pressed_.reset();
+	released_.reset();
+	mouse_pressed_ = 0;
+	mouse_released_ = 0;
+	mouse_dx_ = 0;
+	mouse_dy_ = 0;
+	wheel_ = 0.f;
+}
+
+void input_state::handle(SDL_Event const & event)
+{
+	switch (event.type)
+	{
+	case SDL_KEYDOWN:
+		if (!event.key.repeat && event.key.keysym.scancode < SDL_NUM_SCANCODES)
+			pressed_.set(event.key.keysym.scancode);
+		break;
+	case SDL_KEYUP:
+		if (event.key.keysym.scancode < SDL_NUM_SCANCODES)
+			released_.set(event.key.keysym.scancode);
+		break;
+	case SDL_MOUSEMOTION:
+		mouse_x_ = event.motion.x;
+		mouse_y_ = event.motion.y;
+		mouse_dx_ += event.motion.xrel;
+		mouse_dy_ += event.motion.yrel;
+		break;
+	case SDL_MOUSEBUTTONDOWN:
+		mouse_x_ = event.button.x;
+		mouse_y_ = event.button.y;
+		mouse_down_ |= SDL_BUTTON(event.button.button);
+		mouse_pressed_ |= SDL_BUTTON(event.button.button);
+		break;
+	case SDL_MOUSEBUTTONUP:
+		mouse_x_ = event.button.x;
+		mouse_y_ = event.button.y;
+		mouse_down_ &= ~SDL_BUTTON(event.button.button);
+		mouse_released_ |= SDL_BUTTON(event.button.button);
+		break;
+	case SDL_MOUSEWHEEL:
+		wheel_ += event.wheel.y;
+		break;
+	}
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#ifdef WIN32
+#include <SDL.h>
+#else
+#include <SDL2/SDL.h>
+#endif
+
+#include <bitset>
+#include <cstdint>
+
+// Keyboard and mouse state of the current frame, indexed by scancode (the
+// physical key, independent of the layout). Call begin_frame() before
+// polling the frame's events and pass each of them to handle(); events of
+// other types are ignored.
+//
+// down() reads the array SDL updates while pumping events
+// (SDL_GetKeyboardState), pressed() and released() are edges collected from
+// the events, so a key that went down and up within one frame reports both.
+// Key repeats are not presses. Mouse motion is coalesced into one position
+// and one accumulated delta per frame.
+class input_state
+{
+public:
+	// Requires SDL to be initialized
+	input_state();
+
+	void begin_frame();
+	void handle(SDL_Event const & event);
+
+	bool down(SDL_Scancode key) const { return keys_[key] != 0; }
+	bool pressed(SDL_Scancode key) const { return pressed_[key]; }
+	bool released(SDL_Scancode key) const { return released_[key]; }
+
+	// `button` is SDL_BUTTON_LEFT etc.
+	bool mouse_down(int button) const { return mouse_down_ & SDL_BUTTON(button); }
+	bool mouse_pressed(int button) const { return mouse_pressed_ & SDL_BUTTON(button); }
+	bool mouse_released(int button) const { return mouse_released_ & SDL_BUTTON(button); }
+
+	// Window coordinates of the last motion or button event
+	int mouse_x() const { return mouse_x_; }
+	int mouse_y() const { return mouse_y_; }
+	// Sums over the frame's events
+	int mouse_dx() const { return mouse_dx_; }
+	int mouse_dy() const { return mouse_dy_; }
+	float wheel() const { return wheel_; }
+
+private:
+	Uint8 const * keys_;
+	std::bitset<SDL_NUM_SCANCODES> pressed_;
+	std::bitset<SDL_NUM_SCANCODES> released_;
+
+	std::uint32_t mouse_down_ = 0;
+	std::uint32_t mouse_pressed_ = 0;
+	std::uint32_t mouse_released_ = 0;
+	int mouse_x_ = 0;
+	int mouse_y_ = 0;
+	int mouse_dx_ = 0;
+	int mouse_dy_ = 0;
+	float wheel_ = 0.f;
+};
@@ -0,0 +1,122 @@
+#include "mapped_file.h"
+
+#include <stdexcept>
+#include <utility>
+
+#ifdef WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+mapped_file::mapped_file(std::string const & path)
+{
+#ifdef WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		throw std::runtime_error("Failed to open " + path);
+	file_ = file;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size))
+	{
+		close();
+		throw std::runtime_error("Failed to query size of " + path);
+	}
+	size_ = static_cast<std::size_t>(size.QuadPart);
+	if (size_ == 0)
+		return;
+
+	mapping_ = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping_)
+	{
+		close();
+		throw std::runtime_error("Failed to map " + path);
+	}
+
+	data_ = static_cast<std::uint8_t const *>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+	if (!data_)
+	{
+		close();
+		throw std::runtime_error("Failed to map " + path);
+	}
+#else
+	fd_ = ::open(path.c_str(), O_RDONLY);
+	if (fd_ < 0)
+		throw std::runtime_error("Failed to open " + path + ": " + std::strerror(errno));
+
+	struct stat st;
+	if (::fstat(fd_, &st) != 0)
+	{
+		close();
+		throw std::runtime_error("Failed to stat " + path + ": " + std::strerror(errno));
+	}
+	size_ = static_cast<std::size_t>(st.st_size);
+	if (size_ == 0)
+		return;
+
+	void * data = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+	if (data == MAP_FAILED)
+	{
+		close();
+		throw std::runtime_error("Failed to map " + path + ": " + std::strerror(errno));
+	}
+	data_ = static_cast<std::uint8_t const *>(data);
+#endif
+}
+
+mapped_file::~mapped_file()
+{
+	close();
+}
+
+mapped_file::mapped_file(mapped_file && other) noexcept
+{
+	*this = std::move(other);
+}
+
+mapped_file & mapped_file::operator = (mapped_file && other) noexcept
+{
+	if (this != &other)
+	{
+		close();
+		std::swap(data_, other.data_);
+		std::swap(size_, other.size_);
+#ifdef WIN32
+		std::swap(file_, other.file_);
+		std::swap(mapping_, other.mapping_);
+#else
+		std::swap(fd_, other.fd_);
+#endif
+	}
+	return *this;
+}
+
+void mapped_file::close()
+{
+#ifdef WIN32
+	if (data_)
+		UnmapViewOfFile(data_);
+	if (mapping_)
+		CloseHandle(mapping_);
+	if (file_)
+		CloseHandle(file_);
+	mapping_ = nullptr;
+	file_ = nullptr;
+#else
+	if (data_)
+		::munmap(const_cast<std::uint8_t *>(data_), size_);
+	if (fd_ >= 0)
+		::close(fd_);
+	fd_ = -1;
+#endif
+	data_ = nullptr;
+	size_ = 0;
+}
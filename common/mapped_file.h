@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <span>
+
+// Read-only memory mapping of a whole file. Pages are brought in by the OS
+// on first access, so opening even a huge file costs next to nothing.
+class mapped_file
+{
+public:
+	explicit mapped_file(std::string const & path);
+	~mapped_file();
+
+	mapped_file(mapped_file && other) noexcept;
+	mapped_file & operator = (mapped_file && other) noexcept;
+
+	mapped_file(mapped_file const &) = delete;
+	mapped_file & operator = (mapped_file const &) = delete;
+
+	std::uint8_t const * data() const { return data_; }
+	std::size_t size() const { return size_; }
+
+	std::span<std::uint8_t const> bytes() const { return {data_, size_}; }
+
+private:
+	std::uint8_t const * data_ = nullptr;
+	std::size_t size_ = 0;
+#ifdef WIN32
+	void * file_ = nullptr;
+	void * mapping_ = nullptr;
+#else
+	int fd_ = -1;
+#endif
+
+	void close();
+};
@@ -0,0 +1,508 @@
+#include "mesh.h"
+#include "mapped_file.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+
+constexpr std::uint32_t none = std::numeric_limits<std::uint32_t>::max();
+
+// Position / texture coordinate / normal indices of a face corner
+struct corner
+{
+	std::uint32_t position;
+	std::uint32_t texcoords;
+	std::uint32_t normal;
+
+	friend bool operator == (corner const &, corner const &) = default;
+};
+
+// Maps face corners to vertex indices; open addressing with linear
+// probing, which keeps a lookup at one or two cache lines
+class corner_table
+{
+public:
+	corner_table()
+	{
+		rehash(1024);
+	}
+
+	// Index of `key`, or `next` if it wasn't there yet (and is now)
+	std::uint32_t insert(corner const & key, std::uint32_t next)
+	{
+		if (2 * (size_ + 1) > entries_.size())
+			rehash(2 * entries_.size());
+
+		for (std::size_t i = hash(key) & mask_;; i = (i + 1) & mask_)
+		{
+			auto & entry = entries_[i];
+			if (entry.value == none)
+			{
+				entry = {key, next};
+				++size_;
+				return next;
+			}
+			if (entry.key == key)
+				return entry.value;
+		}
+	}
+
+private:
+	struct entry
+	{
+		corner key;
+		std::uint32_t value = none;
+	};
+
+	std::vector<entry> entries_;
+	std::size_t mask_ = 0;
+	std::size_t size_ = 0;
+
+	static std::size_t hash(corner const & key)
+	{
+		std::uint64_t h = key.position * 0x9e3779b97f4a7c15ull;
+		h ^= (key.texcoords + 0x632be59bull) * 0xc2b2ae3d27d4eb4full;
+		h ^= (key.normal + 0x85ebca6bull) * 0x165667b19e3779f9ull;
+		return h ^ (h >> 29);
+	}
+
+	void rehash(std::size_t capacity)
+	{
+		std::vector<entry> old(capacity);
+		old.swap(entries_);
+		mask_ = capacity - 1;
+		for (auto const & e : old)
+			if (e.value != none)
+				for (std::size_t i = hash(e.key) & mask_;; i = (i + 1) & mask_)
+					if (entries_[i].value == none)
+					{
+						entries_[i] = e;
+						break;
+					}
+	}
+};
+
+class obj_parser
+{
+public:
+	obj_parser(char const * begin, char const * end, std::string const & path)
+		: p_(begin)
+		, end_(end)
+		, path_(path)
+	{}
+
+	mesh_data parse()
+	{
+		std::vector<vec3> positions;
+		std::vector<vec2> texcoords;
+		std::vector<vec3> normals;
+		std::vector<std::uint32_t> polygon;
+		std::vector<bool> has_normal;
+
+		corner_table table;
+		mesh_data result;
+
+		for (; p_ < end_; next_line())
+		{
+			skip_spaces();
+			if (p_ + 1 >= end_)
+				continue;
+
+			if (p_[0] == 'v' && p_[1] == ' ')
+			{
+				p_ += 2;
+				float x = number<float>(), y = number<float>(), z = number<float>();
+				positions.push_back({x, y, z});
+			}
+			else if (p_[0] == 'v' && p_[1] == 't')
+			{
+				p_ += 2;
+				float u = number<float>();
+				skip_spaces();
+				// The second coordinate is optional
+				float v = at_line_end() ? 0.f : number<float>();
+				texcoords.push_back({u, v});
+			}
+			else if (p_[0] == 'v' && p_[1] == 'n')
+			{
+				p_ += 2;
+				float x = number<float>(), y = number<float>(), z = number<float>();
+				normals.push_back({x, y, z});
+			}
+			else if (p_[0] == 'f' && p_[1] == ' ')
+			{
+				++p_;
+				polygon.clear();
+				for (skip_spaces(); !at_line_end(); skip_spaces())
+				{
+					corner c{resolve(number<long>(), positions.size()), none, none};
+					if (p_ < end_ && *p_ == '/')
+					{
+						++p_;
+						if (p_ < end_ && *p_ != '/')
+							c.texcoords = resolve(number<long>(), texcoords.size());
+						if (p_ < end_ && *p_ == '/')
+						{
+							++p_;
+							c.normal = resolve(number<long>(), normals.size());
+						}
+					}
+
+					std::uint32_t index = table.insert(c, result.vertices.size());
+					if (index == result.vertices.size())
+					{
+						result.vertices.push_back({
+							positions[c.position],
+							c.normal != none ? normals[c.normal] : vec3{0.f, 0.f, 0.f},
+							c.texcoords != none ? texcoords[c.texcoords] : vec2{0.f, 0.f},
+						});
+						has_normal.push_back(c.normal != none);
+					}
+					polygon.push_back(index);
+				}
+
+				if (polygon.size() < 3)
+					fail("face with less than 3 vertices");
+				for (std::size_t i = 2; i < polygon.size(); ++i)
+					result.indices.insert(result.indices.end(), {polygon[0], polygon[i - 1], polygon[i]});
+			}
+		}
+
+		if (result.indices.empty())
+			throw std::runtime_error(path_ + " contains no faces");
+
+		generate_missing_normals(result, has_normal);
+		return result;
+	}
+
+private:
+	char const * p_;
+	char const * end_;
+	std::string const & path_;
+	std::size_t line_ = 1;
+
+	[[noreturn]] void fail(char const * what) const
+	{
+		throw std::runtime_error(path_ + ":" + std::to_string(line_) + ": " + what);
+	}
+
+	bool at_line_end() const
+	{
+		return p_ >= end_ || *p_ == '\n' || *p_ == '\r' || *p_ == '#';
+	}
+
+	void skip_spaces()
+	{
+		while (p_ < end_ && (*p_ == ' ' || *p_ == '\t'))
+			++p_;
+	}
+
+	void next_line()
+	{
+		char const * newline = static_cast<char const *>(std::memchr(p_, '\n', end_ - p_));
+		p_ = newline ? newline + 1 : end_;
+		++line_;
+	}
+
+	template <typename T>
+	T number()
+	{
+		skip_spaces();
+		T value{};
+		auto [next, error] = std::from_chars(p_, end_, value);
+		if (error != std::errc())
+			fail("expected a number");
+		p_ = next;
+		return value;
+	}
+
+	// OBJ indices are 1-based, negative ones count back from the last element
+	std::uint32_t resolve(long index, std::size_t count) const
+	{
+		long resolved = index < 0 ? long(count) + index : index - 1;
+		if (index == 0 || resolved < 0 || std::size_t(resolved) >= count)
+			fail("index out of range");
+		return std::uint32_t(resolved);
+	}
+
+	static void generate_missing_normals(mesh_data & mesh, std::vector<bool> const & has_normal)
+	{
+		if (std::all_of(has_normal.begin(), has_normal.end(), [](bool b){ return b; }))
+			return;
+
+		for (std::size_t t = 0; t < mesh.indices.size(); t += 3)
+		{
+			auto & a = mesh.vertices[mesh.indices[t]];
+			auto & b = mesh.vertices[mesh.indices[t + 1]];
+			auto & c = mesh.vertices[mesh.indices[t + 2]];
+			// The cross product's length is twice the area, which is the weight
+			vec3 n = cross(b.position - a.position, c.position - a.position);
+			for (auto i : {mesh.indices[t], mesh.indices[t + 1], mesh.indices[t + 2]})
+				if (!has_normal[i])
+					mesh.vertices[i].normal = mesh.vertices[i].normal + n;
+		}
+
+		for (std::size_t i = 0; i < mesh.vertices.size(); ++i)
+		{
+			if (has_normal[i])
+				continue;
+			auto & n = mesh.vertices[i].normal;
+			n = dot(n, n) > 0.f ? normalize(n) : vec3{0.f, 0.f, 1.f};
+		}
+	}
+};
+
+// Triangles using each vertex, as offsets into one flat array
+struct vertex_adjacency
+{
+	std::vector<std::uint32_t> offsets;
+	std::vector<std::uint32_t> triangles;
+
+	vertex_adjacency(std::span<std::uint32_t const> indices, std::size_t vertex_count)
+		: offsets(vertex_count + 1, 0)
+		, triangles(indices.size())
+	{
+		for (auto v : indices)
+			++offsets[v + 1];
+		for (std::size_t v = 0; v < vertex_count; ++v)
+			offsets[v + 1] += offsets[v];
+
+		std::vector<std::uint32_t> fill(offsets.begin(), offsets.end() - 1);
+		for (std::size_t i = 0; i < indices.size(); ++i)
+			triangles[fill[indices[i]]++] = i / 3;
+	}
+
+	std::span<std::uint32_t const> of(std::uint32_t vertex) const
+	{
+		return {triangles.data() + offsets[vertex], triangles.data() + offsets[vertex + 1]};
+	}
+};
+
+// Tipsify; returns the reordered triangle indices and the triangle
+// positions at which the walk jumped to a vertex that wasn't a candidate
+std::vector<std::uint32_t> tipsify(std::span<std::uint32_t const> indices, std::size_t vertex_count,
+	std::size_t cache_size, std::vector<std::size_t> & jumps)
+{
+	vertex_adjacency adjacency(indices, vertex_count);
+
+	std::vector<std::uint32_t> live(vertex_count);
+	for (std::size_t v = 0; v < vertex_count; ++v)
+		live[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+
+	std::vector<std::uint32_t> cache_time(vertex_count, 0);
+	std::vector<std::uint8_t> emitted(indices.size() / 3, 0);
+	std::vector<std::uint32_t> dead_end;
+	std::vector<std::uint32_t> candidates;
+
+	std::vector<std::uint32_t> result;
+	result.reserve(indices.size());
+
+	std::uint32_t time = cache_size + 1;
+	std::size_t cursor = 0;
+	std::int64_t fanning = 0;
+
+	while (fanning >= 0)
+	{
+		candidates.clear();
+		for (auto t : adjacency.of(fanning))
+		{
+			if (emitted[t])
+				continue;
+			for (std::size_t k = 0; k < 3; ++k)
+			{
+				std::uint32_t v = indices[3 * t + k];
+				result.push_back(v);
+				dead_end.push_back(v);
+				candidates.push_back(v);
+				--live[v];
+				if (time - cache_time[v] > cache_size)
+					cache_time[v] = time++;
+			}
+			emitted[t] = 1;
+		}
+
+		// The candidate that stays in the cache the longest while all its
+		// remaining triangles are emitted
+		fanning = -1;
+		std::int64_t best_priority = -1;
+		for (auto v : candidates)
+		{
+			if (live[v] == 0)
+				continue;
+			std::int64_t priority = 0;
+			if (time - cache_time[v] + 2 * live[v] <= cache_size)
+				priority = time - cache_time[v];
+			if (priority > best_priority)
+			{
+				best_priority = priority;
+				fanning = v;
+			}
+		}
+		if (fanning >= 0)
+			continue;
+
+		jumps.push_back(result.size() / 3);
+		while (!dead_end.empty() && fanning < 0)
+		{
+			std::uint32_t v = dead_end.back();
+			dead_end.pop_back();
+			if (live[v] > 0)
+				fanning = v;
+		}
+		for (; fanning < 0 && cursor < vertex_count; ++cursor)
+			if (live[cursor] > 0)
+				fanning = cursor;
+	}
+
+	return result;
+}
+
+}
+
+mesh_data load_obj(std::string const & path)
+{
+	mapped_file file(path);
+	auto const * begin = reinterpret_cast<char const *>(file.data());
+	mesh_data result = obj_parser(begin, begin + file.size(), path).parse();
+
+	result.bounds_min = result.bounds_max = result.vertices.front().position;
+	for (auto const & v : result.vertices)
+	{
+		auto & lo = result.bounds_min;
+		auto & hi = result.bounds_max;
+		lo = {std::min(lo.x, v.position.x), std::min(lo.y, v.position.y), std::min(lo.z, v.position.z)};
+		hi = {std::max(hi.x, v.position.x), std::max(hi.y, v.position.y), std::max(hi.z, v.position.z)};
+	}
+	return result;
+}
+
+void optimize_mesh(mesh_data & mesh, std::size_t cache_size, std::size_t min_cluster_size)
+{
+	std::vector<std::size_t> jumps;
+	std::vector<std::uint32_t> ordered = tipsify(mesh.indices, mesh.vertices.size(), cache_size, jumps);
+	std::size_t const triangle_count = ordered.size() / 3;
+
+	// Clusters start at the jumps, small ones are merged with their successors
+	std::vector<std::size_t> starts{0};
+	for (auto jump : jumps)
+		if (jump < triangle_count && jump - starts.back() >= min_cluster_size)
+			starts.push_back(jump);
+	starts.push_back(triangle_count);
+
+	struct cluster
+	{
+		std::size_t begin;
+		std::size_t end;
+		float potential;
+	};
+
+	auto const & v = mesh.vertices;
+	auto triangle = [&](std::size_t t, vec3 & centroid, vec3 & area_normal){
+		vec3 a = v[ordered[3 * t]].position, b = v[ordered[3 * t + 1]].position, c = v[ordered[3 * t + 2]].position;
+		centroid = (a + b + c) * (1.f / 3.f);
+		area_normal = cross(b - a, c - a);
+	};
+
+	// Area-weighted centroid of the whole mesh
+	vec3 mesh_centroid{0.f, 0.f, 0.f};
+	float mesh_area = 0.f;
+	for (std::size_t t = 0; t < triangle_count; ++t)
+	{
+		vec3 centroid, area_normal;
+		triangle(t, centroid, area_normal);
+		float area = length(area_normal);
+		mesh_centroid = mesh_centroid + centroid * area;
+		mesh_area += area;
+	}
+	if (mesh_area > 0.f)
+		mesh_centroid = mesh_centroid * (1.f / mesh_area);
+
+	// Clusters facing away from the centre are likely to occlude the rest
+	std::vector<cluster> clusters;
+	for (std::size_t i = 0; i + 1 < starts.size(); ++i)
+	{
+		vec3 centroid_sum{0.f, 0.f, 0.f}, normal_sum{0.f, 0.f, 0.f};
+		float area_sum = 0.f;
+		for (std::size_t t = starts[i]; t < starts[i + 1]; ++t)
+		{
+			vec3 centroid, area_normal;
+			triangle(t, centroid, area_normal);
+			float area = length(area_normal);
+			centroid_sum = centroid_sum + centroid * area;
+			normal_sum = normal_sum + area_normal;
+			area_sum += area;
+		}
+
+		float potential = 0.f;
+		if (area_sum > 0.f && dot(normal_sum, normal_sum) > 0.f)
+			potential = dot(centroid_sum * (1.f / area_sum) - mesh_centroid, normalize(normal_sum));
+		clusters.push_back({starts[i], starts[i + 1], potential});
+	}
+
+	std::stable_sort(clusters.begin(), clusters.end(), [](cluster const & a, cluster const & b){
+		return a.potential > b.potential;
+	});
+
+	auto out = mesh.indices.begin();
+	for (auto const & c : clusters)
+		out = std::copy(ordered.begin() + 3 * c.begin, ordered.begin() + 3 * c.end, out);
+}
+
+float average_cache_miss_ratio(std::span<std::uint32_t const> indices, std::size_t vertex_count, std::size_t cache_size)
+{
+	if (indices.empty())
+		return 0.f;
+
+	// A vertex is in the FIFO if fewer than `cache_size` misses happened since it was inserted
+	std::vector<std::size_t> inserted(vertex_count, 0);
+	std::size_t misses = 0;
+	for (auto v : indices)
+	{
+		if (inserted[v] != 0 && misses - inserted[v] < cache_size)
+			continue;
+		++misses;
+		inserted[v] = misses;
+	}
+	return float(misses) / (indices.size() / 3);
+}
+
+mesh_buffers build_mesh_buffers(mesh_data const & mesh, vertex_layout const & layout, mesh_vertex_encoder const & encode)
+{
+	mesh_buffers result;
+	result.vertex_count = 0;
+	result.vertex_data.resize(mesh.vertices.size() * layout.stride());
+
+	auto & indices = result.indices;
+	indices.type = select_index_type(mesh.vertices.size());
+	indices.count = mesh.indices.size();
+	indices.data.resize(indices.count * index_type_size(indices.type));
+
+	std::vector<std::uint32_t> remap(mesh.vertices.size(), none);
+	for (std::size_t i = 0; i < mesh.indices.size(); ++i)
+	{
+		std::uint32_t & index = remap[mesh.indices[i]];
+		if (index == none)
+		{
+			index = result.vertex_count++;
+			encode(mesh.vertices[mesh.indices[i]], result.vertex_data.data() + index * layout.stride());
+		}
+
+		auto * dst = indices.data.data() + i * index_type_size(indices.type);
+		if (indices.type == GL_UNSIGNED_SHORT)
+		{
+			std::uint16_t narrow = index;
+			std::memcpy(dst, &narrow, sizeof(narrow));
+		}
+		else
+			std::memcpy(dst, &index, sizeof(index));
+	}
+
+	// Vertices no triangle refers to aren't emitted
+	result.vertex_data.resize(result.vertex_count * layout.stride());
+	return result;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "vector_math.h"
+#include "vertex_format.h"
+
+struct mesh_vertex
+{
+	vec3 position;
+	vec3 normal;
+	vec2 texcoords;
+};
+
+// Indexed triangle mesh with unique vertices
+struct mesh_data
+{
+	std::vector<mesh_vertex> vertices;
+	std::vector<std::uint32_t> indices;
+	vec3 bounds_min;
+	vec3 bounds_max;
+};
+
+// Reads the triangles of a Wavefront OBJ file (positions, texture
+// coordinates, normals; polygons are triangulated as fans, everything else
+// is ignored). The file is memory-mapped and parsed in a single pass.
+// v/vt/vn combinations are deduplicated with an open-addressing hash table,
+// so every vertex is stored once. Vertices without a normal get the
+// area-weighted average of their faces' normals.
+// Throws std::runtime_error on malformed input.
+mesh_data load_obj(std::string const & path);
+
+// Reorders triangles for the post-transform vertex cache with Tipsify
+// (Sander, Nehab, Barczak: "Fast Triangle Reordering for Vertex Locality and
+// Reduced Overdraw", 2007), which runs in linear time. The triangles are
+// then grouped into clusters at the points where the walk had to jump, and
+// clusters that face outwards are moved first, so that they tend to occlude
+// the ones drawn later. `cache_size` is the FIFO size of the modelled cache;
+// clusters smaller than `min_cluster_size` triangles are merged.
+void optimize_mesh(mesh_data & mesh, std::size_t cache_size = 16, std::size_t min_cluster_size = 64);
+
+// Average number of vertex shader invocations per triangle with a FIFO cache
+// of `cache_size` entries; 0.5 is the ideal for large regular meshes, 3 the worst
+float average_cache_miss_ratio(std::span<std::uint32_t const> indices, std::size_t vertex_count, std::size_t cache_size = 16);
+
+struct mesh_buffers
+{
+	std::vector<std::uint8_t> vertex_data;
+	std::size_t vertex_count;
+	packed_indices indices;
+};
+
+// Writes `encode(vertex, dst)` for every vertex of `layout` in the order
+// the indices first reference them (which keeps vertex fetches sequential),
+// and the remapped indices in the narrowest type, in one pass over the index
+// list. The results can be passed to glBufferData as they are.
+using mesh_vertex_encoder = std::function<void(mesh_vertex const & vertex, std::uint8_t * dst)>;
+mesh_buffers build_mesh_buffers(mesh_data const & mesh, vertex_layout const & layout, mesh_vertex_encoder const & encode);
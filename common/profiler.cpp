@@ -0,0 +1,189 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <numeric>
+
+rolling_histogram::rolling_histogram(std::size_t capacity)
+	: samples_(capacity)
+{
+	scratch_.reserve(capacity);
+}
+
+void rolling_histogram::add(float value)
+{
+	samples_[next_] = value;
+	next_ = (next_ + 1) % samples_.size();
+	count_ = std::min(count_ + 1, samples_.size());
+}
+
+float rolling_histogram::last() const
+{
+	if (count_ == 0)
+		return 0.f;
+	return samples_[(next_ + samples_.size() - 1) % samples_.size()];
+}
+
+float rolling_histogram::mean() const
+{
+	if (count_ == 0)
+		return 0.f;
+	return std::accumulate(samples_.begin(), samples_.begin() + count_, 0.f) / count_;
+}
+
+float rolling_histogram::max() const
+{
+	if (count_ == 0)
+		return 0.f;
+	return *std::max_element(samples_.begin(), samples_.begin() + count_);
+}
+
+float rolling_histogram::percentile(float p) const
+{
+	if (count_ == 0)
+		return 0.f;
+
+	// Until the window is full, valid samples are exactly the first count_ ones
+	scratch_.assign(samples_.begin(), samples_.begin() + count_);
+	std::size_t rank = std::min<std::size_t>(count_ - 1, std::size_t(p / 100.f * count_));
+	std::nth_element(scratch_.begin(), scratch_.begin() + rank, scratch_.end());
+	return scratch_[rank];
+}
+
+gpu_timer::gpu_timer(std::size_t depth)
+	: queries_(depth)
+	, pending_(depth, false)
+{
+	glGenQueries(queries_.size(), queries_.data());
+}
+
+gpu_timer::~gpu_timer()
+{
+	glDeleteQueries(queries_.size(), queries_.data());
+}
+
+void gpu_timer::begin()
+{
+	active_ = !pending_[next_];
+	if (active_)
+		glBeginQuery(GL_TIME_ELAPSED, queries_[next_]);
+}
+
+void gpu_timer::end()
+{
+	if (!active_)
+		return;
+
+	glEndQuery(GL_TIME_ELAPSED);
+	pending_[next_] = true;
+	next_ = (next_ + 1) % queries_.size();
+	active_ = false;
+}
+
+void gpu_timer::collect(rolling_histogram & target)
+{
+	while (pending_[oldest_])
+	{
+		GLint available = GL_FALSE;
+		glGetQueryObjectiv(queries_[oldest_], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+			break;
+
+		GLuint64 elapsed_ns = 0;
+		glGetQueryObjectui64v(queries_[oldest_], GL_QUERY_RESULT, &elapsed_ns);
+		target.add(elapsed_ns / 1e6f);
+
+		pending_[oldest_] = false;
+		oldest_ = (oldest_ + 1) % queries_.size();
+	}
+}
+
+frame_profiler::frame_profiler(std::string title)
+	: title_(std::move(title))
+{
+	if (char const * csv_path = std::getenv("PRACTICE_PROFILE_CSV"))
+		csv_.open(csv_path);
+}
+
+frame_profiler::section & frame_profiler::cpu_section(std::string_view name)
+{
+	for (auto & s : sections_)
+		if (s.name == name)
+			return s;
+	auto & result = sections_.emplace_back();
+	result.name = name;
+	return result;
+}
+
+void frame_profiler::end_frame(float dt)
+{
+	float frame_ms = dt * 1000.f;
+	frame_times_.add(frame_ms);
+	gpu_.collect(gpu_times_);
+
+	if (csv_.is_open())
+		write_csv_row(frame_ms);
+
+	for (auto & s : sections_)
+	{
+		if (s.touched)
+			s.histogram.add(s.current);
+		s.current = 0.f;
+		s.touched = false;
+	}
+
+	++frame_count_;
+}
+
+void frame_profiler::update_overlay(SDL_Window * window)
+{
+	auto now = std::chrono::steady_clock::now();
+	if (now - last_overlay_update_ < std::chrono::milliseconds(500))
+		return;
+	last_overlay_update_ = now;
+
+	SDL_SetWindowTitle(window, (title_ + "  |  " + summary()).c_str());
+}
+
+std::string frame_profiler::summary() const
+{
+	char buffer[128];
+	std::snprintf(buffer, sizeof(buffer), "frame %.2f ms (p50 %.2f, p95 %.2f, p99 %.2f)",
+		frame_times_.mean(), frame_times_.percentile(50.f), frame_times_.percentile(95.f), frame_times_.percentile(99.f));
+	std::string result = buffer;
+
+	if (gpu_times_.count() > 0)
+	{
+		std::snprintf(buffer, sizeof(buffer), ", gpu %.2f ms", gpu_times_.mean());
+		result += buffer;
+	}
+
+	for (auto const & s : sections_)
+	{
+		std::snprintf(buffer, sizeof(buffer), ", %s %.2f ms", s.name.c_str(), s.histogram.mean());
+		result += buffer;
+	}
+
+	return result;
+}
+
+void frame_profiler::write_csv_row(float frame_ms)
+{
+	// Sections created after the first frame don't get a column
+	if (!csv_header_written_)
+	{
+		csv_ << "frame,frame_ms,gpu_ms";
+		for (auto const & s : sections_)
+			csv_ << ',' << s.name << "_ms";
+		csv_ << '\n';
+		csv_header_written_ = true;
+		csv_columns_ = sections_.size();
+	}
+
+	// GPU results lag a few frames behind, this is the latest one available
+	csv_ << frame_count_ << ',' << frame_ms << ',' << gpu_times_.last();
+	for (std::size_t i = 0; i < csv_columns_; ++i)
+		csv_ << ',' << sections_[i].current;
+	csv_ << '\n';
+}
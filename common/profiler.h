@@ -0,0 +1,154 @@
+#pragma once
+
+#ifdef WIN32
+#include <SDL.h>
+#else
+#include <SDL2/SDL.h>
+#endif
+
+#include <GL/glew.h>
+
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Fixed-size window over the latest samples, in milliseconds
+class rolling_histogram
+{
+public:
+	explicit rolling_histogram(std::size_t capacity = 1024);
+
+	void add(float value);
+
+	std::size_t count() const { return count_; }
+	float last() const;
+	float mean() const;
+	float max() const;
+
+	// `p` in [0, 100]; nearest-rank over the current window
+	float percentile(float p) const;
+
+private:
+	std::vector<float> samples_;
+	std::size_t next_ = 0;
+	std::size_t count_ = 0;
+	mutable std::vector<float> scratch_;
+};
+
+// Ring of GL_TIME_ELAPSED queries. Results are only read once the driver
+// reports them available, so measuring never stalls the pipeline; they
+// arrive a few frames late. Only one timer may be active at a time (GL
+// doesn't allow nested GL_TIME_ELAPSED queries).
+class gpu_timer
+{
+public:
+	explicit gpu_timer(std::size_t depth = 4);
+	~gpu_timer();
+
+	gpu_timer(gpu_timer const &) = delete;
+	gpu_timer & operator = (gpu_timer const &) = delete;
+
+	// If every query in the ring is still pending, this interval is skipped
+	void begin();
+	void end();
+
+	// Moves every finished measurement (in milliseconds) into `target`
+	void collect(rolling_histogram & target);
+
+private:
+	std::vector<GLuint> queries_;
+	std::vector<bool> pending_;
+	std::size_t next_ = 0;
+	std::size_t oldest_ = 0;
+	bool active_ = false;
+};
+
+// Per-target profiling: frame times, named CPU sections and GPU time with
+// rolling p50/p95/p99 statistics. A summary is shown in the window title;
+// if the PRACTICE_PROFILE_CSV environment variable names a file, one row
+// per frame is written there as well.
+class frame_profiler
+{
+public:
+	struct section
+	{
+		std::string name;
+		rolling_histogram histogram;
+		// Time accumulated during the current frame
+		float current = 0.f;
+		bool touched = false;
+	};
+
+	explicit frame_profiler(std::string title);
+
+	// Returns a stable reference; look sections up once, outside the frame loop
+	section & cpu_section(std::string_view name);
+
+	void begin_gpu() { gpu_.begin(); }
+	void end_gpu() { gpu_.end(); }
+
+	// Records the frame that just took `dt` seconds
+	void end_frame(float dt);
+
+	// Shows the current statistics in the window title, at most twice a second
+	void update_overlay(SDL_Window * window);
+
+	rolling_histogram const & frame_times() const { return frame_times_; }
+	rolling_histogram const & gpu_times() const { return gpu_times_; }
+	std::deque<section> const & sections() const { return sections_; }
+	std::size_t frame_count() const { return frame_count_; }
+
+	std::string summary() const;
+
+private:
+	std::string title_;
+	rolling_histogram frame_times_;
+	rolling_histogram gpu_times_;
+	std::deque<section> sections_;
+	gpu_timer gpu_;
+	std::size_t frame_count_ = 0;
+	std::ofstream csv_;
+	bool csv_header_written_ = false;
+	std::size_t csv_columns_ = 0;
+	std::chrono::steady_clock::time_point last_overlay_update_;
+
+	void write_csv_row(float frame_ms);
+};
+
+// Adds the time between construction and destruction to a section
+class scoped_timer
+{
+public:
+	explicit scoped_timer(frame_profiler::section & target)
+		: target_(target)
+		, start_(std::chrono::steady_clock::now())
+	{}
+
+	~scoped_timer()
+	{
+		stop();
+	}
+
+	// Ends the measured interval before the end of the scope
+	void stop()
+	{
+		if (stopped_)
+			return;
+		auto elapsed = std::chrono::steady_clock::now() - start_;
+		target_.current += std::chrono::duration<float, std::milli>(elapsed).count();
+		target_.touched = true;
+		stopped_ = true;
+	}
+
+	scoped_timer(scoped_timer const &) = delete;
+	scoped_timer & operator = (scoped_timer const &) = delete;
+
+private:
+	frame_profiler::section & target_;
+	std::chrono::steady_clock::time_point start_;
+	bool stopped_ = false;
+};
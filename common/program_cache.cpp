@@ -0,0 +1,197 @@
+#include "program_cache.h"
+
+#ifdef WIN32
+#include <SDL.h>
+#else
+#include <SDL2/SDL.h>
+#endif
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+namespace
+{
+
+constexpr char entry_magic[4] = {'P', 'B', 'I', 'N'};
+constexpr std::uint32_t entry_version = 1;
+
+struct entry_header
+{
+	char magic[4];
+	std::uint32_t version;
+	std::uint32_t format;
+	std::uint32_t size;
+	// Repeated inside the file to reject entries that were renamed or truncated
+	std::uint64_t key;
+};
+
+// 64-bit FNV-1a
+std::uint64_t hash(std::uint64_t seed, std::string_view data)
+{
+	for (unsigned char c : data)
+	{
+		seed ^= c;
+		seed *= 0x100000001b3ull;
+	}
+	return seed;
+}
+
+std::uint64_t entry_key(std::string const & driver, char const * vertex_source, char const * fragment_source)
+{
+	std::uint64_t result = 0xcbf29ce484222325ull;
+	// Separators keep e.g. ("ab", "c") and ("a", "bc") apart
+	for (std::string_view part : {std::string_view(driver), std::string_view(vertex_source), std::string_view(fragment_source)})
+		result = hash(hash(result, part), std::string_view("\0", 1));
+	return result;
+}
+
+std::string gl_string(GLenum name)
+{
+	auto value = reinterpret_cast<char const *>(glGetString(name));
+	return value ? value : "";
+}
+
+}
+
+program_cache::program_cache(std::filesystem::path directory)
+	: directory_(std::move(directory))
+	, driver_(gl_string(GL_VENDOR) + '\n' + gl_string(GL_RENDERER) + '\n' + gl_string(GL_VERSION))
+{
+	GLint format_count = 0;
+	if (GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary)
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &format_count);
+
+	std::error_code error;
+	if (format_count == 0 || (!directory_.empty() && !std::filesystem::create_directories(directory_, error) && error))
+		directory_.clear();
+}
+
+std::filesystem::path program_cache::default_directory()
+{
+	if (char const * path = std::getenv("PRACTICE_SHADER_CACHE"))
+		return path;
+
+	std::filesystem::path result;
+	if (char * pref_path = SDL_GetPrefPath("graphics-course", "shader-cache"))
+	{
+		result = pref_path;
+		SDL_free(pref_path);
+	}
+	return result;
+}
+
+gl_program program_cache::load(char const * vertex_source, char const * fragment_source)
+{
+	if (GLuint program = find(vertex_source, fragment_source))
+		return gl_program(program);
+
+	auto vertex_shader = create_shader(GL_VERTEX_SHADER, vertex_source);
+	auto fragment_shader = create_shader(GL_FRAGMENT_SHADER, fragment_source);
+	auto result = create_program(vertex_shader, fragment_shader, enabled());
+	store(vertex_source, fragment_source, result);
+	return result;
+}
+
+GLuint program_cache::find(char const * vertex_source, char const * fragment_source)
+{
+	GLuint result = enabled() ? read_entry(entry_key(driver_, vertex_source, fragment_source)) : 0;
+	++(result ? hits_ : misses_);
+	return result;
+}
+
+void program_cache::store(char const * vertex_source, char const * fragment_source, GLuint program)
+{
+	if (enabled())
+		write_entry(entry_key(driver_, vertex_source, fragment_source), program);
+}
+
+std::filesystem::path program_cache::entry_path(std::uint64_t key) const
+{
+	char name[32];
+	std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+	return directory_ / name;
+}
+
+GLuint program_cache::read_entry(std::uint64_t key) const
+{
+	auto path = entry_path(key);
+	std::ifstream input(path, std::ios::binary);
+	if (!input)
+		return 0;
+
+	entry_header header;
+	std::vector<char> binary;
+	if (input.read(reinterpret_cast<char *>(&header), sizeof(header))
+		&& std::memcmp(header.magic, entry_magic, sizeof(entry_magic)) == 0
+		&& header.version == entry_version
+		&& header.key == key)
+	{
+		binary.resize(header.size);
+		if (!input.read(binary.data(), binary.size()))
+			binary.clear();
+	}
+	input.close();
+
+	if (!binary.empty())
+	{
+		GLuint program = glCreateProgram();
+		glProgramBinary(program, header.format, binary.data(), binary.size());
+
+		GLint status = GL_FALSE;
+		glGetProgramiv(program, GL_LINK_STATUS, &status);
+		if (status == GL_TRUE)
+			return program;
+
+		glDeleteProgram(program);
+	}
+
+	// Corrupt or rejected by the driver; it will be rewritten after compiling
+	std::error_code error;
+	std::filesystem::remove(path, error);
+	return 0;
+}
+
+void program_cache::write_entry(std::uint64_t key, GLuint program) const
+{
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0)
+		return;
+
+	std::vector<char> binary(length);
+	GLenum format = 0;
+	glGetProgramBinary(program, length, &length, &format, binary.data());
+
+	entry_header header;
+	std::memcpy(header.magic, entry_magic, sizeof(entry_magic));
+	header.version = entry_version;
+	header.format = format;
+	header.size = length;
+	header.key = key;
+
+	// Written under a temporary name first, so that a concurrently starting
+	// process never reads a partial entry
+	auto path = entry_path(key);
+	auto temporary = path;
+	temporary += ".tmp";
+
+	bool written;
+	{
+		std::ofstream output(temporary, std::ios::binary);
+		output.write(reinterpret_cast<char const *>(&header), sizeof(header));
+		output.write(binary.data(), length);
+		written = bool(output);
+	}
+
+	// A cache that can't be written only costs compile time on the next start
+	std::error_code error;
+	if (written)
+		std::filesystem::rename(temporary, path, error);
+	if (!written || error)
+		std::filesystem::remove(temporary, error);
+}
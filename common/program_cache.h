@@ -0,0 +1,50 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+#include "shader.h"
+
+// On-disk cache of linked program binaries (GL_ARB_get_program_binary).
+// Entries are keyed by a hash of the shader sources together with the GL
+// vendor, renderer and version strings, so a driver update never even
+// tries a stale binary. A binary the driver rejects anyway is deleted and
+// the program is compiled from source as usual, then stored again.
+//
+// The cache is disabled (every load compiles) when the extension is not
+// supported or the directory is empty.
+class program_cache
+{
+public:
+	explicit program_cache(std::filesystem::path directory = default_directory());
+
+	// PRACTICE_SHADER_CACHE if set, otherwise a per-user SDL preference directory
+	static std::filesystem::path default_directory();
+
+	// Returns the cached program or compiles it, blocking until it is linked
+	gl_program load(char const * vertex_source, char const * fragment_source);
+
+	// The two halves of load() for callers that compile on their own:
+	// find() returns a linked program restored from the cache or 0, and
+	// store() saves a program linked with the retrievable hint
+	GLuint find(char const * vertex_source, char const * fragment_source);
+	void store(char const * vertex_source, char const * fragment_source, GLuint program);
+
+	bool enabled() const { return !directory_.empty(); }
+	int hits() const { return hits_; }
+	int misses() const { return misses_; }
+
+private:
+	std::filesystem::path directory_;
+	std::string driver_;
+	int hits_ = 0;
+	int misses_ = 0;
+
+	std::filesystem::path entry_path(std::uint64_t key) const;
+	// 0 if there is no usable entry
+	GLuint read_entry(std::uint64_t key) const;
+	void write_entry(std::uint64_t key, GLuint program) const;
+};
@@ -0,0 +1,104 @@
+#include "program_compiler.h"
+
+program_compiler::program_compiler(program_cache & cache)
+	: cache_(cache)
+	, parallel_(GLEW_KHR_parallel_shader_compile || GLEW_ARB_parallel_shader_compile)
+{
+	// Let the driver pick the number of compiler threads
+	if (GLEW_KHR_parallel_shader_compile)
+		glMaxShaderCompilerThreadsKHR(0xFFFFFFFFu);
+	else if (GLEW_ARB_parallel_shader_compile)
+		glMaxShaderCompilerThreadsARB(0xFFFFFFFFu);
+}
+
+program_compiler::handle program_compiler::submit(char const * vertex_source, char const * fragment_source)
+{
+	handle result = entries_.size();
+	auto & e = entries_.emplace_back();
+	e.vertex_source = vertex_source;
+	e.fragment_source = fragment_source;
+
+	if (GLuint cached = cache_.find(vertex_source, fragment_source))
+	{
+		e.result.emplace(cached);
+		return result;
+	}
+
+	e.vertex_shader = gl_shader(glCreateShader(GL_VERTEX_SHADER));
+	glShaderSource(e.vertex_shader, 1, &vertex_source, nullptr);
+	glCompileShader(e.vertex_shader);
+
+	e.fragment_shader = gl_shader(glCreateShader(GL_FRAGMENT_SHADER));
+	glShaderSource(e.fragment_shader, 1, &fragment_source, nullptr);
+	glCompileShader(e.fragment_shader);
+
+	// Linking doesn't have to wait for the compile results either
+	e.program = gl_object<gl_program_traits>(glCreateProgram());
+	if (cache_.enabled())
+		glProgramParameteri(e.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	glAttachShader(e.program, e.vertex_shader);
+	glAttachShader(e.program, e.fragment_shader);
+	glLinkProgram(e.program);
+
+	return result;
+}
+
+gl_program const * program_compiler::try_get(handle program)
+{
+	auto & e = entries_[program];
+	if (!e.result)
+	{
+		if (!completed(e))
+			return nullptr;
+		finish(e);
+	}
+	return &*e.result;
+}
+
+gl_program const & program_compiler::get(handle program)
+{
+	auto & e = entries_[program];
+	if (!e.result)
+		finish(e);
+	return *e.result;
+}
+
+std::size_t program_compiler::pending()
+{
+	std::size_t result = 0;
+	for (auto const & e : entries_)
+		if (!e.result && !(parallel_ && completed(e)))
+			++result;
+	return result;
+}
+
+bool program_compiler::completed(entry const & e) const
+{
+	if (!parallel_)
+		return true;
+
+	GLint status = GL_FALSE;
+	glGetProgramiv(e.program, GL_COMPLETION_STATUS_KHR, &status);
+	return status == GL_TRUE;
+}
+
+void program_compiler::finish(entry & e)
+{
+	GLint status;
+	glGetProgramiv(e.program, GL_LINK_STATUS, &status);
+	if (status != GL_TRUE)
+	{
+		// A compile error explains a failed link better than the link log
+		check_shader(e.vertex_shader);
+		check_shader(e.fragment_shader);
+		check_program(e.program);
+	}
+
+	glDetachShader(e.program, e.vertex_shader);
+	glDetachShader(e.program, e.fragment_shader);
+	e.vertex_shader.reset();
+	e.fragment_shader.reset();
+
+	cache_.store(e.vertex_source, e.fragment_source, e.program);
+	e.result.emplace(e.program.release());
+}
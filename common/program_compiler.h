@@ -0,0 +1,63 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <deque>
+#include <optional>
+
+#include "gl_object.h"
+#include "shader.h"
+#include "program_cache.h"
+
+// Submits every program to the driver up front and only checks on them
+// later, so that compilation overlaps with whatever the caller does in
+// between (e.g. loading assets or rendering the first frames with a simpler
+// program). Querying a compile or link status forces the driver to finish
+// that work synchronously; with KHR/ARB_parallel_shader_compile the
+// completion can be polled without blocking instead.
+//
+// Programs found in the cache are restored immediately.
+class program_compiler
+{
+public:
+	using handle = std::size_t;
+
+	explicit program_compiler(program_cache & cache);
+
+	// The sources must stay alive until the program is ready
+	handle submit(char const * vertex_source, char const * fragment_source);
+
+	// Null while the driver is still working on the program. Without the
+	// parallel compile extension there is no way to tell without blocking,
+	// so this waits like get() does.
+	gl_program const * try_get(handle program);
+
+	// Blocks until the program is linked; throws std::runtime_error with
+	// the info log if compiling or linking failed
+	gl_program const & get(handle program);
+
+	// Number of programs still being compiled; doesn't block
+	std::size_t pending();
+
+	bool parallel() const { return parallel_; }
+
+private:
+	struct entry
+	{
+		char const * vertex_source;
+		char const * fragment_source;
+		gl_shader vertex_shader{0};
+		gl_shader fragment_shader{0};
+		gl_object<gl_program_traits> program{0};
+		std::optional<gl_program> result;
+	};
+
+	program_cache & cache_;
+	bool parallel_;
+	// A deque keeps the returned references stable
+	std::deque<entry> entries_;
+
+	bool completed(entry const & e) const;
+	void finish(entry & e);
+};
@@ -0,0 +1,124 @@
+#include "program_library.h"
+#include "file_watcher.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+
+std::string read_source(std::filesystem::path const & path)
+{
+	std::ifstream input(path, std::ios::binary);
+	if (!input)
+		throw std::runtime_error("Failed to open shader " + path.string());
+
+	std::ostringstream contents;
+	contents << input.rdbuf();
+	return std::move(contents).str();
+}
+
+}
+
+program_library::program_library(program_compiler & compiler, std::filesystem::path directory, file_watcher * watcher)
+	: compiler_(compiler)
+	, directory_(std::move(directory))
+	, watcher_(watcher)
+{}
+
+program_library::handle program_library::add(std::string const & vertex_file, std::string const & fragment_file, link_callback on_link)
+{
+	handle result = entries_.size();
+	auto & e = entries_.emplace_back();
+	e.vertex_path = directory_ / vertex_file;
+	e.fragment_path = directory_ / fragment_file;
+	e.vertex_source = read_source(e.vertex_path);
+	e.fragment_source = read_source(e.fragment_path);
+	e.compiled = compiler_.submit(e.vertex_source.c_str(), e.fragment_source.c_str());
+	e.on_link = std::move(on_link);
+
+	if (watcher_)
+	{
+		watcher_->watch(e.vertex_path.string());
+		watcher_->watch(e.fragment_path.string());
+	}
+
+	return result;
+}
+
+gl_program const * program_library::try_get(handle program)
+{
+	auto & e = entries_[program];
+	if (e.reloaded)
+		return &*e.reloaded;
+
+	auto compiled = compiler_.try_get(e.compiled);
+	return compiled ? &current(e, *compiled) : nullptr;
+}
+
+gl_program const & program_library::get(handle program)
+{
+	auto & e = entries_[program];
+	if (e.reloaded)
+		return *e.reloaded;
+
+	return current(e, compiler_.get(e.compiled));
+}
+
+bool program_library::reload(gl_state & state, std::span<std::string const> changed_files)
+{
+	auto changed = [&](std::filesystem::path const & path)
+	{
+		return std::find(changed_files.begin(), changed_files.end(), path.string()) != changed_files.end();
+	};
+
+	bool replaced = false;
+	for (handle i = 0; i < entries_.size(); ++i)
+	{
+		auto & e = entries_[i];
+		if (!changed(e.vertex_path) && !changed(e.fragment_path))
+			continue;
+
+		try
+		{
+			// The callback of the first build runs before the replacement's
+			get(i);
+
+			auto const vertex_source = read_source(e.vertex_path);
+			auto const fragment_source = read_source(e.fragment_path);
+			auto vertex_shader = create_shader(GL_VERTEX_SHADER, vertex_source.c_str());
+			auto fragment_shader = create_shader(GL_FRAGMENT_SHADER, fragment_source.c_str());
+			auto program = create_program(vertex_shader, fragment_shader);
+			if (e.on_link)
+				e.on_link(program);
+
+			e.reloaded = std::move(program);
+			replaced = true;
+			std::cout << "Reloaded " << e.vertex_path.filename().string() << " + " << e.fragment_path.filename().string() << std::endl;
+		}
+		catch (std::exception const & error)
+		{
+			std::cerr << "Keeping the previous program: " << error.what() << std::endl;
+		}
+	}
+
+	// The old names may be reused by the new programs, and the callbacks
+	// may have bound them directly
+	if (replaced)
+		state.invalidate();
+	return replaced;
+}
+
+gl_program const & program_library::current(entry & e, gl_program const & compiled)
+{
+	if (!e.linked)
+	{
+		e.linked = true;
+		if (e.on_link)
+			e.on_link(compiled);
+	}
+	return compiled;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <span>
+#include <string>
+
+#include "shader.h"
+#include "program_compiler.h"
+#include "gl_state.h"
+
+class file_watcher;
+
+// Programs built from shader files in one directory. The first build goes
+// through program_compiler (so it is cached and overlaps with loading);
+// after that, a program whose files change on disk is recompiled by
+// reload() and replaces the old one only if it compiled and linked, so a
+// typo in an edited shader keeps the last working version on screen.
+//
+// Callers fetch programs with get() every frame instead of keeping
+// references across reload() calls.
+class program_library
+{
+public:
+	using handle = std::size_t;
+
+	// Called for every newly linked program, e.g. to bind uniform blocks
+	// and samplers
+	using link_callback = std::function<void(gl_program const &)>;
+
+	// With a watcher, every added file is watched for changes
+	program_library(program_compiler & compiler, std::filesystem::path directory, file_watcher * watcher = nullptr);
+
+	program_library(program_library const &) = delete;
+	program_library & operator = (program_library const &) = delete;
+
+	// File names are relative to the directory; throws std::runtime_error
+	// if one can't be read
+	handle add(std::string const & vertex_file, std::string const & fragment_file, link_callback on_link = {});
+
+	// Same as program_compiler::try_get() and get() for the first build
+	gl_program const * try_get(handle program);
+	gl_program const & get(handle program);
+
+	// Recompiles the programs that use any of `changed_files` (as reported
+	// by file_watcher::changes()). Must be called between frames: replaced
+	// programs are deleted right away, and `state` is invalidated when
+	// anything was replaced. Failures are printed to std::cerr. Returns
+	// whether any program was replaced.
+	bool reload(gl_state & state, std::span<std::string const> changed_files);
+
+private:
+	struct entry
+	{
+		std::filesystem::path vertex_path;
+		std::filesystem::path fragment_path;
+		// The sources of the first build, which the compiler reads from
+		// until it is done
+		std::string vertex_source;
+		std::string fragment_source;
+		program_compiler::handle compiled;
+		link_callback on_link;
+		// Set by the first successful reload
+		std::optional<gl_program> reloaded;
+		bool linked = false;
+	};
+
+	program_compiler & compiler_;
+	std::filesystem::path directory_;
+	file_watcher * watcher_;
+	// A deque keeps the sources in place while more programs are added
+	std::deque<entry> entries_;
+
+	gl_program const & current(entry & e, gl_program const & compiled);
+};
@@ -0,0 +1,43 @@
+#include "radix_sort.h"
+
+#include <bit>
+#include <cstddef>
+#include <utility>
+
+std::uint32_t order_preserving_bits(float value)
+{
+	std::uint32_t bits = std::bit_cast<std::uint32_t>(value);
+	return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+}
+
+// Least significant digit first, one byte per pass. Passes where every
+// key has the same digit (e.g. the high state bytes of a typical frame)
+// are skipped, since they wouldn't move anything.
+void radix_sort(std::vector<sort_entry> & entries, std::vector<sort_entry> & scratch)
+{
+	constexpr std::size_t digits = sizeof(std::uint64_t);
+
+	if (entries.empty())
+		return;
+
+	std::size_t histograms[digits][256] = {};
+	for (auto const & entry : entries)
+		for (std::size_t d = 0; d < digits; ++d)
+			++histograms[d][(entry.key >> (8 * d)) & 0xff];
+
+	scratch.resize(entries.size());
+	for (std::size_t d = 0; d < digits; ++d)
+	{
+		auto & histogram = histograms[d];
+		if (histogram[(entries.front().key >> (8 * d)) & 0xff] == entries.size())
+			continue;
+
+		std::size_t offset = 0;
+		for (auto & count : histogram)
+			offset += std::exchange(count, offset);
+
+		for (auto const & entry : entries)
+			scratch[histogram[(entry.key >> (8 * d)) & 0xff]++] = entry;
+		entries.swap(scratch);
+	}
+}
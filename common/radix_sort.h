@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Key and payload of one element to sort, e.g. a draw and its index
+struct sort_entry
+{
+	std::uint64_t key;
+	std::uint32_t index;
+};
+
+// Maps floats to unsigned integers with the same order
+std::uint32_t order_preserving_bits(float value);
+
+// Stable sort by key in linear time. `scratch` is resized to match and,
+// like `entries`, keeps its capacity, so that callers sorting every frame
+// don't allocate.
+void radix_sort(std::vector<sort_entry> & entries, std::vector<sort_entry> & scratch);
@@ -0,0 +1,109 @@
+#include "shader.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+gl_program::gl_program(GLuint id)
+	: id_(id)
+{
+	GLint uniform_count = 0;
+	glGetProgramiv(id, GL_ACTIVE_UNIFORMS, &uniform_count);
+	GLint max_name_length = 0;
+	glGetProgramiv(id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_name_length);
+
+	std::string name(max_name_length, '\0');
+	for (GLint i = 0; i < uniform_count; ++i)
+	{
+		GLsizei length = 0;
+		GLint size;
+		GLenum type;
+		glGetActiveUniform(id, i, name.size(), &length, &size, &type, name.data());
+
+		// Members of uniform blocks have no location
+		GLint location = glGetUniformLocation(id, name.c_str());
+		if (location == -1)
+			continue;
+
+		std::string_view key(name.data(), length);
+		if (key.size() > 3 && key.substr(key.size() - 3) == "[0]")
+			key.remove_suffix(3);
+		uniforms_.emplace_back(key, location);
+	}
+
+	std::sort(uniforms_.begin(), uniforms_.end());
+}
+
+GLint gl_program::uniform(std::string_view name) const
+{
+	auto it = std::lower_bound(uniforms_.begin(), uniforms_.end(), name, [](auto const & entry, std::string_view name){
+		return entry.first < name;
+	});
+	if (it == uniforms_.end() || it->first != name)
+		return -1;
+	return it->second;
+}
+
+void check_shader(GLuint shader)
+{
+	GLint status;
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+	if (status != GL_TRUE)
+	{
+		GLint info_log_length;
+		glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &info_log_length);
+		std::string info_log(info_log_length, '\0');
+		glGetShaderInfoLog(shader, info_log.size(), nullptr, info_log.data());
+		throw std::runtime_error("Shader compilation failed: " + info_log);
+	}
+}
+
+void check_program(GLuint program)
+{
+	GLint status;
+	glGetProgramiv(program, GL_LINK_STATUS, &status);
+	if (status != GL_TRUE)
+	{
+		GLint info_log_length;
+		glGetProgramiv(program, GL_INFO_LOG_LENGTH, &info_log_length);
+		std::string info_log(info_log_length, '\0');
+		glGetProgramInfoLog(program, info_log.size(), nullptr, info_log.data());
+		throw std::runtime_error("Program linkage failed: " + info_log);
+	}
+}
+
+gl_shader create_shader(GLenum type, const char * source)
+{
+	gl_shader result(glCreateShader(type));
+	glShaderSource(result, 1, &source, nullptr);
+	glCompileShader(result);
+	check_shader(result);
+	return result;
+}
+
+gl_program create_program(GLuint vertex_shader, GLuint fragment_shader, bool retrievable)
+{
+	gl_object<gl_program_traits> result(glCreateProgram());
+	if (retrievable)
+		glProgramParameteri(result, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	glAttachShader(result, vertex_shader);
+	glAttachShader(result, fragment_shader);
+	glLinkProgram(result);
+	check_program(result);
+
+	// The shaders may be deleted by their owners, the program keeps its binary
+	glDetachShader(result, vertex_shader);
+	glDetachShader(result, fragment_shader);
+
+	return gl_program(result.release());
+}
+
+gl_program create_compute_program(GLuint compute_shader)
+{
+	gl_object<gl_program_traits> result(glCreateProgram());
+	glAttachShader(result, compute_shader);
+	glLinkProgram(result);
+	check_program(result);
+	glDetachShader(result, compute_shader);
+
+	return gl_program(result.release());
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "gl_object.h"
+
+struct gl_program_traits
+{
+	static void destroy(GLuint id) { glDeleteProgram(id); }
+};
+
+// Linked program together with the locations of all its active uniforms,
+// collected once at link time; uniform() never calls into the driver
+class gl_program
+{
+public:
+	// Takes ownership of a successfully linked program
+	explicit gl_program(GLuint id);
+
+	GLuint id() const { return id_; }
+	operator GLuint() const { return id_; }
+
+	// -1 (ignored by glUniform*) if there is no such active uniform;
+	// arrays are found by their name without the "[0]" suffix
+	GLint uniform(std::string_view name) const;
+
+private:
+	gl_object<gl_program_traits> id_;
+	// Sorted by name
+	std::vector<std::pair<std::string, GLint>> uniforms_;
+};
+
+// Throw std::runtime_error with the info log on failure. `retrievable`
+// asks the driver to keep the binary available for glGetProgramBinary
+// (requires GL_ARB_get_program_binary).
+gl_shader create_shader(GLenum type, const char * source);
+gl_program create_program(GLuint vertex_shader, GLuint fragment_shader, bool retrievable = false);
+// Requires GL 4.3 or ARB_compute_shader
+gl_program create_compute_program(GLuint compute_shader);
+
+// Throw std::runtime_error with the info log if compilation or linking
+// failed; both block until the driver has finished the work
+void check_shader(GLuint shader);
+void check_program(GLuint program);
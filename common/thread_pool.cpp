@@ -0,0 +1,183 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+
+namespace
+{
+
+// Set for the lifetime of each worker thread
+thread_local void const * current_pool = nullptr;
+thread_local std::size_t current_queue = 0;
+
+}
+
+bool thread_pool::job::done() const
+{
+	return !state_ || state_->done;
+}
+
+void thread_pool::job::wait()
+{
+	if (!state_)
+		return;
+
+	std::size_t const home = pool_->home_queue();
+	while (!state_->done)
+	{
+		if (pool_->run_one(home))
+			continue;
+
+		// Nothing left to help with, the job is running on another thread
+		std::unique_lock lock(state_->mutex);
+		state_->cv.wait(lock, [this]{ return state_->done.load(); });
+	}
+}
+
+thread_pool::thread_pool(std::size_t thread_count)
+{
+	if (thread_count == 0)
+		thread_count = std::max(2u, std::thread::hardware_concurrency()) - 1;
+
+	for (std::size_t i = 0; i < thread_count; ++i)
+		queues_.push_back(std::make_unique<task_queue>());
+
+	for (std::size_t i = 0; i < thread_count; ++i)
+		workers_.emplace_back([this, i]{ work(i); });
+}
+
+thread_pool::~thread_pool()
+{
+	{
+		std::lock_guard lock(sleep_mutex_);
+		stop_ = true;
+	}
+	wake_.notify_all();
+	for (auto & worker : workers_)
+		worker.join();
+}
+
+void thread_pool::submit(std::function<void()> task)
+{
+	std::size_t const queue = current_pool == this ? current_queue : next_queue_.fetch_add(1) % queues_.size();
+	{
+		std::lock_guard lock(queues_[queue]->mutex);
+		queues_[queue]->tasks.push_back(std::move(task));
+	}
+	{
+		std::lock_guard lock(sleep_mutex_);
+		++pending_;
+	}
+	wake_.notify_one();
+}
+
+thread_pool::job thread_pool::async(std::function<void()> task)
+{
+	job result;
+	result.pool_ = this;
+	result.state_ = std::make_shared<job::state>();
+
+	submit([state = result.state_, task = std::move(task)]
+	{
+		task();
+		{
+			std::lock_guard lock(state->mutex);
+			state->done = true;
+		}
+		state->cv.notify_all();
+	});
+	return result;
+}
+
+void thread_pool::parallel_for(std::size_t count, std::size_t chunk_size, std::function<void(std::size_t, std::size_t)> const & body)
+{
+	chunk_size = std::max<std::size_t>(chunk_size, 1);
+	std::size_t const chunk_count = (count + chunk_size - 1) / chunk_size;
+	if (chunk_count == 0)
+		return;
+
+	struct state
+	{
+		std::atomic<std::size_t> next{0};
+		std::atomic<std::size_t> done{0};
+		std::mutex mutex;
+		std::condition_variable cv;
+	};
+	auto shared = std::make_shared<state>();
+
+	// Chunks are claimed from a shared counter; helpers that only start after
+	// everything has been claimed return immediately, so the caller never
+	// waits for a task that hasn't actually started
+	auto run = [shared, chunk_count, chunk_size, count, &body]
+	{
+		for (std::size_t chunk; (chunk = shared->next.fetch_add(1)) < chunk_count;)
+		{
+			std::size_t begin = chunk * chunk_size;
+			body(begin, std::min(begin + chunk_size, count));
+			if (shared->done.fetch_add(1) + 1 == chunk_count)
+			{
+				std::lock_guard lock(shared->mutex);
+				shared->cv.notify_all();
+			}
+		}
+	};
+
+	std::size_t helpers = std::min(workers_.size(), chunk_count - 1);
+	for (std::size_t i = 0; i < helpers; ++i)
+		submit(run);
+
+	run();
+
+	std::unique_lock lock(shared->mutex);
+	shared->cv.wait(lock, [&]{ return shared->done == chunk_count; });
+}
+
+bool thread_pool::run_one(std::size_t home)
+{
+	std::function<void()> task;
+	for (std::size_t i = 0; i < queues_.size() && !task; ++i)
+	{
+		auto & queue = *queues_[(home + i) % queues_.size()];
+		std::lock_guard lock(queue.mutex);
+		if (queue.tasks.empty())
+			continue;
+		if (i == 0)
+		{
+			task = std::move(queue.tasks.back());
+			queue.tasks.pop_back();
+		}
+		else
+		{
+			task = std::move(queue.tasks.front());
+			queue.tasks.pop_front();
+		}
+	}
+
+	if (!task)
+		return false;
+
+	--pending_;
+	task();
+	return true;
+}
+
+std::size_t thread_pool::home_queue()
+{
+	return current_pool == this ? current_queue : 0;
+}
+
+void thread_pool::work(std::size_t index)
+{
+	current_pool = this;
+	current_queue = index;
+
+	while (true)
+	{
+		if (run_one(index))
+			continue;
+
+		std::unique_lock lock(sleep_mutex_);
+		wake_.wait(lock, [this]{ return stop_ || pending_ > 0; });
+		if (stop_ && pending_ <= 0)
+			return;
+	}
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// Fixed set of worker threads with one task deque each. A worker runs its
+// own tasks newest first (they are likely still in its cache) and steals
+// the oldest task of another worker when it runs dry; tasks submitted from
+// outside of the pool are spread over the deques round-robin.
+class thread_pool
+{
+public:
+	// Completion handle of a task started with async()
+	class job
+	{
+	public:
+		job() = default;
+
+		bool done() const;
+
+		// Runs other pending tasks of the pool until the job has finished,
+		// so waiting from inside a pool task can't deadlock it. Does nothing
+		// for a default-constructed job.
+		void wait();
+
+	private:
+		friend class thread_pool;
+
+		struct state
+		{
+			std::atomic<bool> done{false};
+			std::mutex mutex;
+			std::condition_variable cv;
+		};
+
+		thread_pool * pool_ = nullptr;
+		std::shared_ptr<state> state_;
+	};
+
+	// Zero means one thread per hardware core (minus the calling thread),
+	// but at least one, so that async() jobs finish even if nobody waits
+	// for them and only polls done()
+	explicit thread_pool(std::size_t thread_count = 0);
+	~thread_pool();
+
+	thread_pool(thread_pool const &) = delete;
+	thread_pool & operator = (thread_pool const &) = delete;
+
+	std::size_t thread_count() const { return workers_.size(); }
+
+	void submit(std::function<void()> task);
+	job async(std::function<void()> task);
+
+	// Calls `body(begin, end)` for consecutive chunks of [0, count) and
+	// returns once all of them are done. The calling thread takes part in
+	// the work, so this is safe to call from inside a pool task as well.
+	void parallel_for(std::size_t count, std::size_t chunk_size, std::function<void(std::size_t, std::size_t)> const & body);
+
+private:
+	struct task_queue
+	{
+		std::mutex mutex;
+		std::deque<std::function<void()>> tasks;
+	};
+
+	std::vector<std::unique_ptr<task_queue>> queues_;
+	std::vector<std::thread> workers_;
+	std::atomic<std::size_t> next_queue_{0};
+
+	// Submitted but not yet started; may briefly drop below zero while a
+	// task is taken before its submitter has counted it
+	std::atomic<std::ptrdiff_t> pending_{0};
+	std::mutex sleep_mutex_;
+	std::condition_variable wake_;
+	bool stop_ = false;
+
+	// Pops from the back of `home`, or steals from the front of the others.
+	// Returns false if every deque was empty.
+	bool run_one(std::size_t home);
+	// The deque of the calling thread if it is one of our workers
+	std::size_t home_queue();
+	void work(std::size_t index);
+};
@@ -0,0 +1,149 @@
+#include "transparency.h"
+
+#include <stdexcept>
+
+namespace
+{
+
+const char resolve_vertex_shader_source[] =
+R"(#version 330 core
+
+const vec2 VERTICES[3] = vec2[3](
+	vec2(-1.0, -1.0),
+	vec2( 3.0, -1.0),
+	vec2(-1.0,  3.0)
+);
+
+void main()
+{
+	gl_Position = vec4(VERTICES[gl_VertexID], 0.0, 1.0);
+}
+)";
+
+const char resolve_fragment_shader_source[] =
+R"(#version 330 core
+
+uniform sampler2D accumulation;
+uniform sampler2D weight;
+
+layout (location = 0) out vec4 out_color;
+
+void main()
+{
+	ivec2 pixel = ivec2(gl_FragCoord.xy);
+	vec4 sum = texelFetch(accumulation, pixel, 0);
+
+	// The alpha channel is the product of (1 - alpha) of every layer
+	float revealage = sum.a;
+	if (revealage == 1.0)
+		discard;
+
+	out_color = vec4(sum.rgb / max(texelFetch(weight, pixel, 0).r, 1e-5), 1.0 - revealage);
+}
+)";
+
+gl_program create_resolve_program()
+{
+	auto vertex_shader = create_shader(GL_VERTEX_SHADER, resolve_vertex_shader_source);
+	auto fragment_shader = create_shader(GL_FRAGMENT_SHADER, resolve_fragment_shader_source);
+	return create_program(vertex_shader, fragment_shader);
+}
+
+}
+
+std::span<std::uint32_t const> depth_sorter::back_to_front(std::span<float const> depths)
+{
+	// Inverted, so that the farthest object gets the smallest key; only the
+	// low four bytes vary, the others are skipped by the sort
+	keys_.resize(depths.size());
+	for (std::size_t i = 0; i < depths.size(); ++i)
+		keys_[i] = {~order_preserving_bits(depths[i]), std::uint32_t(i)};
+	radix_sort(keys_, scratch_);
+
+	order_.resize(keys_.size());
+	for (std::size_t i = 0; i < keys_.size(); ++i)
+		order_[i] = keys_[i].index;
+	return order_;
+}
+
+weighted_oit::weighted_oit()
+	: program_(create_resolve_program())
+{
+	glUseProgram(program_);
+	glUniform1i(program_.uniform("accumulation"), 0);
+	glUniform1i(program_.uniform("weight"), 1);
+}
+
+void weighted_oit::begin(gl_state & state, GLsizei width, GLsizei height)
+{
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &target_);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+
+	if (width != width_ || height != height_)
+	{
+		width_ = width;
+		height_ = height;
+
+		// Float targets, since the weighted sums easily leave [0, 1]
+		auto allocate = [&](GLuint texture, GLenum internal_format, GLenum format)
+		{
+			state.bind_texture(0, GL_TEXTURE_2D, texture);
+			state.active_texture(0);
+			glTexImage2D(GL_TEXTURE_2D, 0, internal_format, width, height, 0, format, GL_FLOAT, nullptr);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		};
+		allocate(accumulation_, GL_RGBA16F, GL_RGBA);
+		allocate(weight_, GL_R16F, GL_RED);
+
+		glBindRenderbuffer(GL_RENDERBUFFER, depth_);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+		glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, accumulation_, 0);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, weight_, 0);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth_);
+
+		GLenum const draw_buffers[] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+		glDrawBuffers(2, draw_buffers);
+
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+			throw std::runtime_error("Weighted OIT framebuffer is incomplete");
+	}
+
+	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+	glDepthMask(GL_TRUE);
+	glClear(GL_DEPTH_BUFFER_BIT);
+	state.enable(GL_DEPTH_TEST);
+}
+
+void weighted_oit::accumulate(gl_state & state)
+{
+	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+	GLfloat const empty_sum[] = {0.f, 0.f, 0.f, 1.f};
+	GLfloat const empty_weight[] = {0.f, 0.f, 0.f, 0.f};
+	glClearBufferfv(GL_COLOR, 0, empty_sum);
+	glClearBufferfv(GL_COLOR, 1, empty_weight);
+
+	// Sums in the color channels, the product of (1 - alpha) in alpha;
+	// surfaces are still tested against the opaque depth, just not written
+	glDepthMask(GL_FALSE);
+	state.enable(GL_BLEND);
+	glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ZERO, GL_ONE_MINUS_SRC_ALPHA);
+}
+
+void weighted_oit::resolve(gl_state & state)
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, target_);
+
+	state.disable(GL_DEPTH_TEST);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	state.use_program(program_);
+	state.bind_texture(0, GL_TEXTURE_2D, accumulation_);
+	state.bind_texture(1, GL_TEXTURE_2D, weight_);
+	state.bind_vertex_array(vao_);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+
+	state.disable(GL_BLEND);
+	glDepthMask(GL_TRUE);
+}
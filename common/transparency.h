@@ -0,0 +1,88 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "gl_object.h"
+#include "gl_state.h"
+#include "radix_sort.h"
+#include "shader.h"
+
+// Two ways of drawing translucent surfaces over an opaque scene:
+//
+// - sorted: classic over-blending, back to front. Exact for non-intersecting
+//   surfaces and costs nothing on the GPU beyond the blended fragments
+//   themselves, but the CPU sorts every frame and surfaces have to be drawn
+//   in that order (e.g. with instance data uploaded sorted).
+// - weighted_oit: weighted blended order-independent transparency (McGuire
+//   and Bavoil, 2013). Surfaces are drawn in any order into two float
+//   targets and resolved in one full-screen pass. No sorting, but every
+//   translucent fragment writes 10 bytes more and the resolve touches every
+//   pixel; the result approximates depth order by weighting.
+enum class transparency_mode
+{
+	sorted,
+	weighted_oit,
+};
+
+// Back-to-front order of translucent objects, radix-sorted on their
+// view-space distances in buffers kept between frames
+class depth_sorter
+{
+public:
+	// Indices into `depths` (which grow away from the camera), farthest
+	// first; valid until the next call
+	std::span<std::uint32_t const> back_to_front(std::span<float const> depths);
+
+private:
+	std::vector<sort_entry> keys_;
+	std::vector<sort_entry> scratch_;
+	std::vector<std::uint32_t> order_;
+};
+
+// Accumulation targets and resolve pass of weighted blended OIT. A frame
+// goes:
+//
+//     begin()         binds the targets (reallocated when the size changes,
+//                     which must match the viewport) with color writes
+//                     masked; draw the occluding opaque geometry, ideally
+//                     with a program that does no shading, since only its
+//                     depth is kept
+//     accumulate()    draw the translucent surfaces with a program whose
+//                     outputs are
+//                         0: vec4(color.rgb * color.a * w, color.a)
+//                         1: color.a * w
+//                     for a weight w that falls off with distance
+//     resolve()       blends the result over the framebuffer that was bound
+//                     at begin(); leaves blending and depth testing
+//                     disabled and depth writes enabled
+//
+// Single-sampled, so translucent surfaces aren't antialiased even when the
+// framebuffer is. Only needs GL 3.3 (one blend function for both targets).
+class weighted_oit
+{
+public:
+	// Sets up its program directly, so create it before the gl_state
+	weighted_oit();
+
+	weighted_oit(weighted_oit const &) = delete;
+	weighted_oit & operator = (weighted_oit const &) = delete;
+
+	void begin(gl_state & state, GLsizei width, GLsizei height);
+	void accumulate(gl_state & state);
+	void resolve(gl_state & state);
+
+private:
+	gl_program program_;
+	gl_vertex_array vao_;
+	gl_framebuffer framebuffer_;
+	gl_texture accumulation_;
+	gl_texture weight_;
+	gl_renderbuffer depth_;
+	GLsizei width_ = 0;
+	GLsizei height_ = 0;
+	GLint target_ = 0;
+};
@@ -0,0 +1,15 @@
+#include "uniform_buffer.h"
+
+void bind_uniform_block(GLuint program, char const * name, GLuint binding)
+{
+	GLuint index = glGetUniformBlockIndex(program, name);
+	if (index != GL_INVALID_INDEX)
+		glUniformBlockBinding(program, index, binding);
+}
+
+std::size_t uniform_buffer_offset_alignment()
+{
+	GLint result = 0;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &result);
+	return std::max<GLint>(result, 1);
+}
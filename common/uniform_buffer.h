@@ -0,0 +1,174 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "gl_object.h"
+#include "vector_math.h"
+
+// Uniform block binding points shared by all programs
+enum uniform_binding : GLuint
+{
+	camera_binding = 0,
+	object_binding = 1,
+};
+
+// Per-frame camera data. Matches
+//     layout (std140) uniform camera { mat4 view; mat4 projection; };
+// mat4 is column-major, which is also the std140 default.
+struct camera_uniforms
+{
+	mat4 view;
+	mat4 projection;
+};
+
+// Connects the uniform block `name` of `program` to `binding`; does nothing
+// if the program has no such active block. GLSL 3.30 has no layout(binding),
+// so this is done once after linking.
+void bind_uniform_block(GLuint program, char const * name, GLuint binding);
+
+// GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT of the current context
+std::size_t uniform_buffer_offset_alignment();
+
+// A single std140 block, rewritten as a whole (typically once per frame)
+// and bound to a fixed binding point for every program that uses it
+template <typename T>
+class uniform_buffer
+{
+public:
+	explicit uniform_buffer(GLuint binding)
+		: binding_(binding)
+	{
+		glBindBuffer(GL_UNIFORM_BUFFER, buffer_);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(T), nullptr, GL_DYNAMIC_DRAW);
+		glBindBufferBase(GL_UNIFORM_BUFFER, binding_, buffer_);
+	}
+
+	void update(T const & value)
+	{
+		glBindBuffer(GL_UNIFORM_BUFFER, buffer_);
+		glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(T), &value);
+	}
+
+	GLuint binding() const { return binding_; }
+	GLuint id() const { return buffer_; }
+
+private:
+	GLuint binding_;
+	gl_buffer buffer_;
+};
+
+// Per-object std140 blocks for many draws per frame. Every frame writes its
+// blocks into the next region of a ring of `frames_in_flight` regions
+// through an unsynchronized mapping; a fence per region guarantees the GPU
+// is done reading it before it is reused. Draws then select their block
+// with glBindBufferRange, so there is no per-draw glUniform* traffic.
+//
+// Per frame: begin_frame(count), set() each object, end_writes(), then
+// bind() before each draw and end_frame() after the last one.
+template <typename T>
+class uniform_ring
+{
+public:
+	static constexpr std::size_t frames_in_flight = 3;
+
+	uniform_ring(GLuint binding, std::size_t capacity)
+		: binding_(binding)
+		, stride_((sizeof(T) + uniform_buffer_offset_alignment() - 1) / uniform_buffer_offset_alignment() * uniform_buffer_offset_alignment())
+		, fences_(frames_in_flight, nullptr)
+	{
+		reserve(capacity);
+	}
+
+	~uniform_ring()
+	{
+		for (auto fence : fences_)
+			if (fence)
+				glDeleteSync(fence);
+	}
+
+	uniform_ring(uniform_ring const &) = delete;
+	uniform_ring & operator = (uniform_ring const &) = delete;
+
+	// Maps the next region for `count` blocks, growing the ring if needed
+	void begin_frame(std::size_t count)
+	{
+		if (count > capacity_)
+			reserve(std::max(count, 2 * capacity_));
+
+		region_ = (region_ + 1) % frames_in_flight;
+		if (GLsync & fence = fences_[region_])
+		{
+			while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64(1000000000)) == GL_TIMEOUT_EXPIRED)
+				;
+			glDeleteSync(fence);
+			fence = nullptr;
+		}
+
+		glBindBuffer(GL_UNIFORM_BUFFER, buffer_);
+		mapped_ = static_cast<char *>(glMapBufferRange(GL_UNIFORM_BUFFER, region_offset(), std::max<std::size_t>(count, 1) * stride_,
+			GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT));
+		if (!mapped_)
+			throw std::runtime_error("Failed to map the uniform ring");
+	}
+
+	void set(std::size_t index, T const & value)
+	{
+		std::memcpy(mapped_ + index * stride_, &value, sizeof(T));
+	}
+
+	// Must be called before the first draw that reads the blocks
+	void end_writes()
+	{
+		glBindBuffer(GL_UNIFORM_BUFFER, buffer_);
+		glUnmapBuffer(GL_UNIFORM_BUFFER);
+		mapped_ = nullptr;
+	}
+
+	void bind(std::size_t index) const
+	{
+		glBindBufferRange(GL_UNIFORM_BUFFER, binding_, buffer_, region_offset() + index * stride_, sizeof(T));
+	}
+
+	// Marks the region as in use by the commands issued so far
+	void end_frame()
+	{
+		fences_[region_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+
+	GLuint binding() const { return binding_; }
+	std::size_t capacity() const { return capacity_; }
+
+private:
+	GLuint binding_;
+	std::size_t stride_;
+	std::size_t capacity_ = 0;
+	std::size_t region_ = 0;
+	char * mapped_ = nullptr;
+	gl_buffer buffer_;
+	std::vector<GLsync> fences_;
+
+	std::size_t region_offset() const
+	{
+		return region_ * capacity_ * stride_;
+	}
+
+	// Reallocating orphans the old storage, so pending fences no longer matter
+	void reserve(std::size_t capacity)
+	{
+		capacity_ = std::max<std::size_t>(capacity, 1);
+		glBindBuffer(GL_UNIFORM_BUFFER, buffer_);
+		glBufferData(GL_UNIFORM_BUFFER, frames_in_flight * capacity_ * stride_, nullptr, GL_DYNAMIC_DRAW);
+		for (auto & fence : fences_)
+		{
+			if (fence)
+				glDeleteSync(fence);
+			fence = nullptr;
+		}
+	}
+};
@@ -0,0 +1,382 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define VECTOR_MATH_SSE 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define VECTOR_MATH_NEON 1
+#endif
+
+// Vector and 4x4 matrix types shared by the practices. Matrices are
+// column-major, like GL expects them by default, so they can be passed to
+// glUniformMatrix4fv without transposing and copied into std140 blocks or
+// mat4 vertex attributes as they are.
+//
+// Everything that doesn't need a square root or a trigonometric function is
+// constexpr; mat4 products and inverses switch to SSE/NEON code outside of
+// constant evaluation.
+
+struct vec2
+{
+	float x;
+	float y;
+};
+
+struct vec3
+{
+	float x;
+	float y;
+	float z;
+};
+
+struct vec4
+{
+	float x;
+	float y;
+	float z;
+	float w;
+};
+
+constexpr vec2 operator + (vec2 a, vec2 b) { return {a.x + b.x, a.y + b.y}; }
+constexpr vec2 operator - (vec2 a, vec2 b) { return {a.x - b.x, a.y - b.y}; }
+constexpr vec2 operator * (vec2 a, float s) { return {a.x * s, a.y * s}; }
+constexpr vec2 operator * (float s, vec2 a) { return a * s; }
+constexpr float dot(vec2 a, vec2 b) { return a.x * b.x + a.y * b.y; }
+
+constexpr vec3 operator + (vec3 a, vec3 b) { return {a.x + b.x, a.y + b.y, a.z + b.z}; }
+constexpr vec3 operator - (vec3 a, vec3 b) { return {a.x - b.x, a.y - b.y, a.z - b.z}; }
+constexpr vec3 operator - (vec3 a) { return {-a.x, -a.y, -a.z}; }
+constexpr vec3 operator * (vec3 a, float s) { return {a.x * s, a.y * s, a.z * s}; }
+constexpr vec3 operator * (float s, vec3 a) { return a * s; }
+constexpr float dot(vec3 a, vec3 b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+constexpr vec3 cross(vec3 a, vec3 b) { return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x}; }
+inline float length(vec3 a) { return std::sqrt(dot(a, a)); }
+inline vec3 normalize(vec3 a) { return a * (1.f / length(a)); }
+
+constexpr vec4 operator + (vec4 a, vec4 b) { return {a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w}; }
+constexpr vec4 operator - (vec4 a, vec4 b) { return {a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w}; }
+constexpr vec4 operator * (vec4 a, vec4 b) { return {a.x * b.x, a.y * b.y, a.z * b.z, a.w * b.w}; }
+constexpr vec4 operator * (vec4 a, float s) { return {a.x * s, a.y * s, a.z * s, a.w * s}; }
+constexpr float dot(vec4 a, vec4 b) { return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w; }
+
+struct alignas(16) mat4
+{
+	vec4 columns[4];
+
+	constexpr vec4 & operator[](std::size_t column) { return columns[column]; }
+	constexpr vec4 const & operator[](std::size_t column) const { return columns[column]; }
+
+	float * data() { return &columns[0].x; }
+	float const * data() const { return &columns[0].x; }
+
+	static constexpr mat4 identity()
+	{
+		return {{
+			{1.f, 0.f, 0.f, 0.f},
+			{0.f, 1.f, 0.f, 0.f},
+			{0.f, 0.f, 1.f, 0.f},
+			{0.f, 0.f, 0.f, 1.f},
+		}};
+	}
+
+	static constexpr mat4 translation(vec3 t)
+	{
+		return {{
+			{1.f, 0.f, 0.f, 0.f},
+			{0.f, 1.f, 0.f, 0.f},
+			{0.f, 0.f, 1.f, 0.f},
+			{t.x, t.y, t.z, 1.f},
+		}};
+	}
+
+	static constexpr mat4 scale(vec3 s)
+	{
+		return {{
+			{s.x, 0.f, 0.f, 0.f},
+			{0.f, s.y, 0.f, 0.f},
+			{0.f, 0.f, s.z, 0.f},
+			{0.f, 0.f, 0.f, 1.f},
+		}};
+	}
+
+	// Counter-clockwise when looking from the positive end of the axis
+	static mat4 rotation_x(float angle)
+	{
+		float c = std::cos(angle), s = std::sin(angle);
+		return {{
+			{1.f, 0.f, 0.f, 0.f},
+			{0.f,   c,   s, 0.f},
+			{0.f,  -s,   c, 0.f},
+			{0.f, 0.f, 0.f, 1.f},
+		}};
+	}
+
+	static mat4 rotation_y(float angle)
+	{
+		float c = std::cos(angle), s = std::sin(angle);
+		return {{
+			{  c, 0.f,  -s, 0.f},
+			{0.f, 1.f, 0.f, 0.f},
+			{  s, 0.f,   c, 0.f},
+			{0.f, 0.f, 0.f, 1.f},
+		}};
+	}
+
+	static mat4 rotation_z(float angle)
+	{
+		float c = std::cos(angle), s = std::sin(angle);
+		return {{
+			{  c,   s, 0.f, 0.f},
+			{ -s,   c, 0.f, 0.f},
+			{0.f, 0.f, 1.f, 0.f},
+			{0.f, 0.f, 0.f, 1.f},
+		}};
+	}
+
+	// glFrustum: maps the view-space box at the near plane to NDC
+	static constexpr mat4 frustum(float left, float right, float bottom, float top, float z_near, float z_far)
+	{
+		return {{
+			{2.f * z_near / (right - left), 0.f, 0.f, 0.f},
+			{0.f, 2.f * z_near / (top - bottom), 0.f, 0.f},
+			{(right + left) / (right - left), (top + bottom) / (top - bottom), -(z_far + z_near) / (z_far - z_near), -1.f},
+			{0.f, 0.f, -2.f * z_far * z_near / (z_far - z_near), 0.f},
+		}};
+	}
+
+	// `fov_y` is the full vertical angle, `aspect` is width / height
+	static mat4 perspective(float fov_y, float aspect, float z_near, float z_far)
+	{
+		float top = z_near * std::tan(fov_y / 2.f);
+		float right = top * aspect;
+		return frustum(-right, right, -top, top, z_near, z_far);
+	}
+
+	// Right-handed view matrix looking from `eye` at `target`
+	static mat4 look_at(vec3 eye, vec3 target, vec3 up)
+	{
+		vec3 z = normalize(eye - target);
+		vec3 x = normalize(cross(up, z));
+		vec3 y = cross(z, x);
+		return {{
+			{x.x, y.x, z.x, 0.f},
+			{x.y, y.y, z.y, 0.f},
+			{x.z, y.z, z.z, 0.f},
+			{-dot(x, eye), -dot(y, eye), -dot(z, eye), 1.f},
+		}};
+	}
+};
+
+namespace vector_math_detail
+{
+
+// 4-wide float vector used by the runtime paths below
+struct float4
+{
+#if defined(VECTOR_MATH_SSE)
+	__m128 v;
+
+	static float4 broadcast(float x) { return {_mm_set1_ps(x)}; }
+	static float4 load(vec4 const & p) { return {_mm_loadu_ps(&p.x)}; }
+	static float4 set(float x, float y, float z, float w) { return {_mm_setr_ps(x, y, z, w)}; }
+	void store(vec4 & p) const { _mm_storeu_ps(&p.x, v); }
+	float sum() const
+	{
+		__m128 t = _mm_add_ps(v, _mm_movehl_ps(v, v));
+		return _mm_cvtss_f32(_mm_add_ss(t, _mm_shuffle_ps(t, t, 1)));
+	}
+
+	friend float4 operator + (float4 a, float4 b) { return {_mm_add_ps(a.v, b.v)}; }
+	friend float4 operator - (float4 a, float4 b) { return {_mm_sub_ps(a.v, b.v)}; }
+	friend float4 operator * (float4 a, float4 b) { return {_mm_mul_ps(a.v, b.v)}; }
+#elif defined(VECTOR_MATH_NEON)
+	float32x4_t v;
+
+	static float4 broadcast(float x) { return {vdupq_n_f32(x)}; }
+	static float4 load(vec4 const & p) { return {vld1q_f32(&p.x)}; }
+	static float4 set(float x, float y, float z, float w)
+	{
+		float lanes[4] = {x, y, z, w};
+		return {vld1q_f32(lanes)};
+	}
+	void store(vec4 & p) const { vst1q_f32(&p.x, v); }
+	float sum() const
+	{
+		float32x2_t t = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+		return vget_lane_f32(vpadd_f32(t, t), 0);
+	}
+
+	friend float4 operator + (float4 a, float4 b) { return {vaddq_f32(a.v, b.v)}; }
+	friend float4 operator - (float4 a, float4 b) { return {vsubq_f32(a.v, b.v)}; }
+	friend float4 operator * (float4 a, float4 b) { return {vmulq_f32(a.v, b.v)}; }
+#else
+	vec4 v;
+
+	static float4 broadcast(float x) { return {{x, x, x, x}}; }
+	static float4 load(vec4 const & p) { return {p}; }
+	static float4 set(float x, float y, float z, float w) { return {{x, y, z, w}}; }
+	void store(vec4 & p) const { p = v; }
+	float sum() const { return (v.x + v.y) + (v.z + v.w); }
+
+	friend float4 operator + (float4 a, float4 b) { return {a.v + b.v}; }
+	friend float4 operator - (float4 a, float4 b) { return {a.v - b.v}; }
+	friend float4 operator * (float4 a, float4 b) { return {a.v * b.v}; }
+#endif
+};
+
+// The same operations on plain vec4, usable in constant expressions
+struct constexpr_float4
+{
+	vec4 v;
+
+	static constexpr constexpr_float4 broadcast(float x) { return {{x, x, x, x}}; }
+	static constexpr constexpr_float4 load(vec4 const & p) { return {p}; }
+	static constexpr constexpr_float4 set(float x, float y, float z, float w) { return {{x, y, z, w}}; }
+	constexpr void store(vec4 & p) const { p = v; }
+	constexpr float sum() const { return (v.x + v.y) + (v.z + v.w); }
+
+	friend constexpr constexpr_float4 operator + (constexpr_float4 a, constexpr_float4 b) { return {a.v + b.v}; }
+	friend constexpr constexpr_float4 operator - (constexpr_float4 a, constexpr_float4 b) { return {a.v - b.v}; }
+	friend constexpr constexpr_float4 operator * (constexpr_float4 a, constexpr_float4 b) { return {a.v * b.v}; }
+};
+
+// Each column of the product is a linear combination of the columns of `a`
+template <typename F>
+constexpr mat4 multiply(mat4 const & a, mat4 const & b)
+{
+	F const a0 = F::load(a[0]), a1 = F::load(a[1]), a2 = F::load(a[2]), a3 = F::load(a[3]);
+	mat4 result{};
+	for (std::size_t i = 0; i < 4; ++i)
+	{
+		vec4 const & c = b[i];
+		(a0 * F::broadcast(c.x) + a1 * F::broadcast(c.y) + a2 * F::broadcast(c.z) + a3 * F::broadcast(c.w)).store(result[i]);
+	}
+	return result;
+}
+
+template <typename F>
+constexpr vec4 transform(mat4 const & m, vec4 const & p)
+{
+	vec4 result{};
+	(F::load(m[0]) * F::broadcast(p.x) + F::load(m[1]) * F::broadcast(p.y) + F::load(m[2]) * F::broadcast(p.z) + F::load(m[3]) * F::broadcast(p.w)).store(result);
+	return result;
+}
+
+// Cofactor expansion with four cofactors per vector operation
+template <typename F>
+constexpr mat4 inverse(mat4 const & m)
+{
+	float const c00 = m[2].z * m[3].w - m[3].z * m[2].w;
+	float const c02 = m[1].z * m[3].w - m[3].z * m[1].w;
+	float const c03 = m[1].z * m[2].w - m[2].z * m[1].w;
+	float const c04 = m[2].y * m[3].w - m[3].y * m[2].w;
+	float const c06 = m[1].y * m[3].w - m[3].y * m[1].w;
+	float const c07 = m[1].y * m[2].w - m[2].y * m[1].w;
+	float const c08 = m[2].y * m[3].z - m[3].y * m[2].z;
+	float const c10 = m[1].y * m[3].z - m[3].y * m[1].z;
+	float const c11 = m[1].y * m[2].z - m[2].y * m[1].z;
+	float const c12 = m[2].x * m[3].w - m[3].x * m[2].w;
+	float const c14 = m[1].x * m[3].w - m[3].x * m[1].w;
+	float const c15 = m[1].x * m[2].w - m[2].x * m[1].w;
+	float const c16 = m[2].x * m[3].z - m[3].x * m[2].z;
+	float const c18 = m[1].x * m[3].z - m[3].x * m[1].z;
+	float const c19 = m[1].x * m[2].z - m[2].x * m[1].z;
+	float const c20 = m[2].x * m[3].y - m[3].x * m[2].y;
+	float const c22 = m[1].x * m[3].y - m[3].x * m[1].y;
+	float const c23 = m[1].x * m[2].y - m[2].x * m[1].y;
+
+	F const f0 = F::set(c00, c00, c02, c03);
+	F const f1 = F::set(c04, c04, c06, c07);
+	F const f2 = F::set(c08, c08, c10, c11);
+	F const f3 = F::set(c12, c12, c14, c15);
+	F const f4 = F::set(c16, c16, c18, c19);
+	F const f5 = F::set(c20, c20, c22, c23);
+
+	F const v0 = F::set(m[1].x, m[0].x, m[0].x, m[0].x);
+	F const v1 = F::set(m[1].y, m[0].y, m[0].y, m[0].y);
+	F const v2 = F::set(m[1].z, m[0].z, m[0].z, m[0].z);
+	F const v3 = F::set(m[1].w, m[0].w, m[0].w, m[0].w);
+
+	F const sign_a = F::set(1.f, -1.f, 1.f, -1.f);
+	F const sign_b = F::set(-1.f, 1.f, -1.f, 1.f);
+
+	mat4 result{};
+	((v1 * f0 - v2 * f1 + v3 * f2) * sign_a).store(result[0]);
+	((v0 * f0 - v2 * f3 + v3 * f4) * sign_b).store(result[1]);
+	((v0 * f1 - v1 * f3 + v3 * f5) * sign_a).store(result[2]);
+	((v0 * f2 - v1 * f4 + v2 * f5) * sign_b).store(result[3]);
+
+	float const determinant = (F::load(m[0]) * F::set(result[0].x, result[1].x, result[2].x, result[3].x)).sum();
+	F const scale = F::broadcast(1.f / determinant);
+	for (std::size_t i = 0; i < 4; ++i)
+		(F::load(result[i]) * scale).store(result[i]);
+	return result;
+}
+
+}
+
+constexpr mat4 operator * (mat4 const & a, mat4 const & b)
+{
+	if (std::is_constant_evaluated())
+		return vector_math_detail::multiply<vector_math_detail::constexpr_float4>(a, b);
+	return vector_math_detail::multiply<vector_math_detail::float4>(a, b);
+}
+
+constexpr vec4 operator * (mat4 const & m, vec4 const & p)
+{
+	if (std::is_constant_evaluated())
+		return vector_math_detail::transform<vector_math_detail::constexpr_float4>(m, p);
+	return vector_math_detail::transform<vector_math_detail::float4>(m, p);
+}
+
+// The result is undefined for singular matrices
+constexpr mat4 inverse(mat4 const & m)
+{
+	if (std::is_constant_evaluated())
+		return vector_math_detail::inverse<vector_math_detail::constexpr_float4>(m);
+	return vector_math_detail::inverse<vector_math_detail::float4>(m);
+}
+
+constexpr mat4 transpose(mat4 const & m)
+{
+	return {{
+		{m[0].x, m[1].x, m[2].x, m[3].x},
+		{m[0].y, m[1].y, m[2].y, m[3].y},
+		{m[0].z, m[1].z, m[2].z, m[3].z},
+		{m[0].w, m[1].w, m[2].w, m[3].w},
+	}};
+}
+
+// world[i] = parent * local[i]; the inner loop of a transform hierarchy
+inline void multiply(mat4 const & parent, mat4 const * local, mat4 * world, std::size_t count)
+{
+	using vector_math_detail::float4;
+	float4 const p0 = float4::load(parent[0]), p1 = float4::load(parent[1]), p2 = float4::load(parent[2]), p3 = float4::load(parent[3]);
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		mat4 const & l = local[i];
+		for (std::size_t c = 0; c < 4; ++c)
+			(p0 * float4::broadcast(l[c].x) + p1 * float4::broadcast(l[c].y) + p2 * float4::broadcast(l[c].z) + p3 * float4::broadcast(l[c].w)).store(world[i][c]);
+	}
+}
+
+// Transforms the vec3 `Member` of every element of a vertex array as a point
+// (w = 1), in place; the perspective divide is not applied
+template <typename Vertex>
+void transform_points(mat4 const & m, Vertex * vertices, std::size_t count, vec3 Vertex::* member = &Vertex::position)
+{
+	using vector_math_detail::float4;
+	float4 const m0 = float4::load(m[0]), m1 = float4::load(m[1]), m2 = float4::load(m[2]), m3 = float4::load(m[3]);
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		vec3 & p = vertices[i].*member;
+		vec4 result;
+		(m0 * float4::broadcast(p.x) + m1 * float4::broadcast(p.y) + m2 * float4::broadcast(p.z) + m3).store(result);
+		p = {result.x, result.y, result.z};
+	}
+}
@@ -0,0 +1,220 @@
+#include "vertex_format.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+
+std::size_t attribute_size(attribute_type type, GLint components)
+{
+	switch (type)
+	{
+	case attribute_type::float32:
+		return 4 * components;
+	case attribute_type::float16:
+	case attribute_type::snorm16:
+	case attribute_type::unorm16:
+		return 2 * components;
+	case attribute_type::unorm8:
+		return components;
+	case attribute_type::snorm10_10_10_2:
+		return 4;
+	}
+	return 0;
+}
+
+GLenum gl_type(attribute_type type)
+{
+	switch (type)
+	{
+	case attribute_type::float32:
+		return GL_FLOAT;
+	case attribute_type::float16:
+		return GL_HALF_FLOAT;
+	case attribute_type::snorm16:
+		return GL_SHORT;
+	case attribute_type::unorm16:
+		return GL_UNSIGNED_SHORT;
+	case attribute_type::unorm8:
+		return GL_UNSIGNED_BYTE;
+	case attribute_type::snorm10_10_10_2:
+		return GL_INT_2_10_10_10_REV;
+	}
+	return GL_FLOAT;
+}
+
+std::size_t align4(std::size_t value)
+{
+	return (value + 3) & ~std::size_t(3);
+}
+
+template <typename T>
+void store(std::uint8_t * dst, T value)
+{
+	std::memcpy(dst, &value, sizeof(T));
+}
+
+// Rounds to nearest and clamps to [-limit, limit]
+std::int32_t quantize_signed(float value, std::int32_t limit)
+{
+	return std::int32_t(std::lround(std::clamp(value, -1.f, 1.f) * limit));
+}
+
+}
+
+vertex_layout & vertex_layout::add(GLuint location, GLint components, attribute_type type)
+{
+	if (components < 1 || components > 4 || (type == attribute_type::snorm10_10_10_2 && components != 4))
+		throw std::runtime_error("Invalid number of vertex attribute components");
+
+	attributes_.push_back({location, components, type, stride_});
+	stride_ = align4(stride_ + attribute_size(type, components));
+	return *this;
+}
+
+void vertex_layout::apply(std::size_t base_offset) const
+{
+	for (auto const & a : attributes_)
+	{
+		bool const normalized = a.type != attribute_type::float32 && a.type != attribute_type::float16;
+		glEnableVertexAttribArray(a.location);
+		glVertexAttribPointer(a.location, a.components, gl_type(a.type), normalized, stride_, (void const *) (base_offset + a.offset));
+	}
+}
+
+void vertex_layout::encode(std::uint8_t * vertex, std::size_t index, vec4 value) const
+{
+	auto const & a = attributes_[index];
+	float const components[4] = {value.x, value.y, value.z, value.w};
+	std::uint8_t * dst = vertex + a.offset;
+
+	for (GLint c = 0; c < a.components; ++c)
+	{
+		switch (a.type)
+		{
+		case attribute_type::float32:
+			store(dst + 4 * c, components[c]);
+			break;
+		case attribute_type::float16:
+			store(dst + 2 * c, pack_half(components[c]));
+			break;
+		case attribute_type::snorm16:
+			store(dst + 2 * c, pack_snorm16(components[c]));
+			break;
+		case attribute_type::unorm16:
+			store(dst + 2 * c, pack_unorm16(components[c]));
+			break;
+		case attribute_type::unorm8:
+			dst[c] = std::uint8_t(std::lround(std::clamp(components[c], 0.f, 1.f) * 255.f));
+			break;
+		case attribute_type::snorm10_10_10_2:
+			store(dst, pack_snorm10_10_10_2(value));
+			return;
+		}
+	}
+}
+
+// Round to nearest even, with overflow to infinity and gradual underflow
+std::uint16_t pack_half(float value)
+{
+	std::uint32_t const bits = std::bit_cast<std::uint32_t>(value);
+	std::uint32_t const sign = (bits >> 16) & 0x8000u;
+	std::uint32_t const magnitude = bits & 0x7fffffffu;
+
+	if (magnitude >= 0x7f800000u)
+		return sign | 0x7c00u | (magnitude > 0x7f800000u ? 0x200u : 0u);
+	if (magnitude >= 0x477ff000u)
+		return sign | 0x7c00u;
+
+	if (magnitude < 0x38800000u)
+	{
+		// Subnormal half: shift the mantissa with its implicit bit into place
+		if (magnitude < 0x33000000u)
+			return sign;
+		std::uint32_t const exponent = magnitude >> 23;
+		std::uint32_t const mantissa = (magnitude & 0x7fffffu) | 0x800000u;
+		std::uint32_t const shift = 126 - exponent;
+		std::uint32_t result = mantissa >> shift;
+		std::uint32_t const rest = mantissa & ((1u << shift) - 1);
+		std::uint32_t const half = 1u << (shift - 1);
+		if (rest > half || (rest == half && (result & 1)))
+			++result;
+		return sign | result;
+	}
+
+	std::uint32_t result = (magnitude - 0x38000000u) >> 13;
+	std::uint32_t const rest = magnitude & 0x1fffu;
+	if (rest > 0x1000u || (rest == 0x1000u && (result & 1)))
+		++result;
+	return sign | result;
+}
+
+std::int16_t pack_snorm16(float value)
+{
+	return std::int16_t(quantize_signed(value, 32767));
+}
+
+std::uint16_t pack_unorm16(float value)
+{
+	return std::uint16_t(std::lround(std::clamp(value, 0.f, 1.f) * 65535.f));
+}
+
+std::uint32_t pack_snorm10_10_10_2(vec4 value)
+{
+	auto field = [](float v, std::int32_t limit, int bits){
+		return std::uint32_t(quantize_signed(v, limit)) & ((1u << bits) - 1);
+	};
+	return field(value.x, 511, 10) | (field(value.y, 511, 10) << 10) | (field(value.z, 511, 10) << 20) | (field(value.w, 1, 2) << 30);
+}
+
+std::size_t index_type_size(GLenum type)
+{
+	switch (type)
+	{
+	case GL_UNSIGNED_BYTE:
+		return 1;
+	case GL_UNSIGNED_SHORT:
+		return 2;
+	default:
+		return 4;
+	}
+}
+
+GLenum select_index_type(std::size_t vertex_count, bool allow_bytes)
+{
+	if (allow_bytes && vertex_count <= std::numeric_limits<std::uint8_t>::max() + std::size_t(1))
+		return GL_UNSIGNED_BYTE;
+	if (vertex_count <= std::numeric_limits<std::uint16_t>::max() + std::size_t(1))
+		return GL_UNSIGNED_SHORT;
+	return GL_UNSIGNED_INT;
+}
+
+packed_indices pack_indices(std::span<std::uint32_t const> indices, std::size_t vertex_count, bool allow_bytes)
+{
+	packed_indices result;
+	result.type = select_index_type(vertex_count, allow_bytes);
+	result.count = indices.size();
+	result.data.resize(indices.size() * index_type_size(result.type));
+
+	auto * dst = result.data.data();
+	switch (result.type)
+	{
+	case GL_UNSIGNED_BYTE:
+		for (std::size_t i = 0; i < indices.size(); ++i)
+			dst[i] = std::uint8_t(indices[i]);
+		break;
+	case GL_UNSIGNED_SHORT:
+		for (std::size_t i = 0; i < indices.size(); ++i)
+			store(dst + 2 * i, std::uint16_t(indices[i]));
+		break;
+	default:
+		std::memcpy(dst, indices.data(), result.data.size());
+		break;
+	}
+	return result;
+}
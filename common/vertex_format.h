@@ -0,0 +1,83 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "vector_math.h"
+
+// Storage of a single vertex attribute. Everything except float32 and
+// float16 is normalized, so shaders always see floats in the usual ranges.
+enum class attribute_type
+{
+	float32,
+	// GL_HALF_FLOAT; exact for integers up to 2048, ~3 significant digits
+	float16,
+	// [-1, 1] in 16 bits, e.g. positions of a mesh scaled into a unit box
+	snorm16,
+	// [0, 1] in 16 bits, e.g. texture coordinates
+	unorm16,
+	// [0, 1] in 8 bits, e.g. colors
+	unorm8,
+	// xyz in 10 bits each and w in 2, all signed normalized, e.g. normals
+	// and tangents; always 4 components packed into 4 bytes
+	snorm10_10_10_2,
+};
+
+struct vertex_attribute
+{
+	GLuint location;
+	GLint components;
+	attribute_type type;
+	std::size_t offset;
+};
+
+// Interleaved vertex layout. Attributes are placed in the order they are
+// added, each aligned to 4 bytes (GPUs fetch unaligned attributes slowly or
+// not at all), and the stride is rounded up to 4 as well.
+class vertex_layout
+{
+public:
+	vertex_layout & add(GLuint location, GLint components, attribute_type type);
+
+	std::size_t stride() const { return stride_; }
+	std::vector<vertex_attribute> const & attributes() const { return attributes_; }
+
+	// Enables and points every attribute of the bound vertex array at the
+	// bound GL_ARRAY_BUFFER, starting `base_offset` bytes into it
+	void apply(std::size_t base_offset = 0) const;
+
+	// Writes the first `components` of `value` as attribute `index` of the
+	// vertex at `vertex`; values are clamped to the range of the type
+	void encode(std::uint8_t * vertex, std::size_t index, vec4 value) const;
+
+private:
+	std::vector<vertex_attribute> attributes_;
+	std::size_t stride_ = 0;
+};
+
+std::uint16_t pack_half(float value);
+std::int16_t pack_snorm16(float value);
+std::uint16_t pack_unorm16(float value);
+std::uint32_t pack_snorm10_10_10_2(vec4 value);
+
+// GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+std::size_t index_type_size(GLenum type);
+
+// The narrowest index type that can address `vertex_count` vertices.
+// Byte indices are opt-in: several GPUs don't fetch them natively and
+// convert them on the CPU or in a slower path.
+GLenum select_index_type(std::size_t vertex_count, bool allow_bytes = false);
+
+struct packed_indices
+{
+	GLenum type;
+	std::size_t count;
+	std::vector<std::uint8_t> data;
+};
+
+// Converts `indices` into the type chosen by select_index_type
+packed_indices pack_indices(std::span<std::uint32_t const> indices, std::size_t vertex_count, bool allow_bytes = false);
@@ -10,56 +10,38 @@
 #include <string_view>
 #include <stdexcept>
 #include <iostream>
-
-std::string to_string(std::string_view str)
-{
-	return std::string(str.begin(), str.end());
-}
-
-void sdl2_fail(std::string_view message)
-{
-	throw std::runtime_error(to_string(message) + SDL_GetError());
-}
-
-void glew_fail(std::string_view message, GLenum error)
-{
-	throw std::runtime_error(to_string(message) + reinterpret_cast<const char *>(glewGetErrorString(error)));
-}
-
-int main() try
+#include <chrono>
+#include <memory>
+#include "gl_window.h"
+#include "profiler.h"
+#include "benchmark.h"
+#include "frame_pacer.h"
+
+int main(int argc, char ** argv) try
 {
-	if (SDL_Init(SDL_INIT_VIDEO) != 0)
-		sdl2_fail("SDL_Init: ");
-
-	SDL_Window * window = SDL_CreateWindow("Graphics course practice 1",
-		SDL_WINDOWPOS_CENTERED,
-		SDL_WINDOWPOS_CENTERED,
-		800, 600,
-		SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE | SDL_WINDOW_MAXIMIZED);
-
-	if (!window)
-		sdl2_fail("SDL_CreateWindow: ");
+	auto options = parse_benchmark_options(argc, argv);
 
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
-	SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
+	gl_window window("Graphics course practice 1", options.window_flags());
+	// Nothing moves, so frames are only drawn after events by default
+	frame_pacer pacer(options.pacing, redraw_mode::on_demand);
 
-	SDL_GLContext gl_context = SDL_GL_CreateContext(window);
-	if (!gl_context)
-		sdl2_fail("SDL_GL_CreateContext: ");
+	glClearColor(0.8f, 0.8f, 1.f, 0.f);
 
-	if (auto result = glewInit(); result != GLEW_NO_ERROR)
-		glew_fail("glewInit: ", result);
+	frame_profiler profiler("Graphics course practice 1");
+	auto & draw_section = profiler.cpu_section("draw");
 
-	if (!GLEW_VERSION_3_3)
-		throw std::runtime_error("OpenGL 3.3 is not supported");
+	std::unique_ptr<benchmark> headless;
+	if (options.headless)
+		headless = std::make_unique<benchmark>(options, "practice1");
 
-	glClearColor(0.8f, 0.8f, 1.f, 0.f);
+	auto last_frame_start = std::chrono::high_resolution_clock::now();
 
 	bool running = true;
 	while (running)
 	{
+		if (!headless)
+			pacer.begin_frame();
+
 		for (SDL_Event event; SDL_PollEvent(&event);) switch (event.type)
 		{
 		case SDL_QUIT:
@@ -70,13 +52,30 @@ int main() try
 		if (!running)
 			break;
 
+		auto now = std::chrono::high_resolution_clock::now();
+		float dt = std::chrono::duration_cast<std::chrono::duration<float>>(now - last_frame_start).count();
+		last_frame_start = now;
+
+		profiler.end_frame(dt);
+		profiler.update_overlay(window);
+
+		scoped_timer draw_timer(draw_section);
+		if (headless)
+			headless->begin_frame();
+		profiler.begin_gpu();
 		glClear(GL_COLOR_BUFFER_BIT);
 
-		SDL_GL_SwapWindow(window);
+		profiler.end_gpu();
+		draw_timer.stop();
+
+		if (headless)
+			running = headless->end_frame();
+		else
+			pacer.present(window);
 	}
 
-	SDL_GL_DeleteContext(gl_context);
-	SDL_DestroyWindow(window);
+	if (headless)
+		headless->report(std::cout, profiler);
 }
 catch (std::exception const & e)
 {
@@ -11,140 +11,67 @@
 #include <stdexcept>
 #include <iostream>
 #include <chrono>
-
-std::string to_string(std::string_view str)
+#include <memory>
+#include <optional>
+#include "gl_window.h"
+#include "shader.h"
+#include "program_cache.h"
+#include "program_compiler.h"
+#include "program_library.h"
+#include "file_watcher.h"
+#include "profiler.h"
+#include "gl_state.h"
+#include "benchmark.h"
+#include "frame_pacer.h"
+
+int main(int argc, char ** argv) try
 {
-	return std::string(str.begin(), str.end());
-}
+	auto options = parse_benchmark_options(argc, argv);
 
-void sdl2_fail(std::string_view message)
-{
-	throw std::runtime_error(to_string(message) + SDL_GetError());
-}
+	gl_window window("Graphics course practice 2", options.window_flags());
+	// Nothing moves, so frames are only drawn after events by default
+	frame_pacer pacer(options.pacing, redraw_mode::on_demand);
 
-void glew_fail(std::string_view message, GLenum error)
-{
-	throw std::runtime_error(to_string(message) + reinterpret_cast<const char *>(glewGetErrorString(error)));
-}
+	int width = window.width(), height = window.height();
 
-const char vertex_shader_source[] =
-R"(#version 330 core
-
-const vec2 VERTICES[3] = vec2[3](
-	vec2(0.0, 0.0),
-	vec2(1.0, 0.0),
-	vec2(0.0, 1.0)
-);
-
-out vec3 color;
-
-void main()
-{
-	vec2 position = VERTICES[gl_VertexID];
-	gl_Position = vec4(position, 0.0, 1.0);
-	color = vec3(position, 0.0);
-}
-)";
-
-const char fragment_shader_source[] =
-R"(#version 330 core
-
-in vec3 color;
-
-layout (location = 0) out vec4 out_color;
+	glClearColor(0.8f, 0.8f, 1.f, 0.f);
 
-void main()
-{
-	out_color = vec4(color, 1.0);
-}
-)";
+	frame_profiler profiler("Graphics course practice 2");
+	auto & draw_section = profiler.cpu_section("draw");
 
-GLuint create_shader(GLenum type, const char * source)
-{
-	GLuint result = glCreateShader(type);
-	glShaderSource(result, 1, &source, nullptr);
-	glCompileShader(result);
-	GLint status;
-	glGetShaderiv(result, GL_COMPILE_STATUS, &status);
-	if (status != GL_TRUE)
+	std::unique_ptr<benchmark> headless;
+	if (options.headless)
 	{
-		GLint info_log_length;
-		glGetShaderiv(result, GL_INFO_LOG_LENGTH, &info_log_length);
-		std::string info_log(info_log_length, '\0');
-		glGetShaderInfoLog(result, info_log.size(), nullptr, info_log.data());
-		throw std::runtime_error("Shader compilation failed: " + info_log);
+		headless = std::make_unique<benchmark>(options, "practice2");
+		width = headless->width();
+		height = headless->height();
 	}
-	return result;
-}
 
-GLuint create_program(GLuint vertex_shader, GLuint fragment_shader)
-{
-	GLuint result = glCreateProgram();
-	glAttachShader(result, vertex_shader);
-	glAttachShader(result, fragment_shader);
-	glLinkProgram(result);
-
-	GLint status;
-	glGetProgramiv(result, GL_LINK_STATUS, &status);
-	if (status != GL_TRUE)
-	{
-		GLint info_log_length;
-		glGetProgramiv(result, GL_INFO_LOG_LENGTH, &info_log_length);
-		std::string info_log(info_log_length, '\0');
-		glGetProgramInfoLog(result, info_log.size(), nullptr, info_log.data());
-		throw std::runtime_error("Program linkage failed: " + info_log);
-	}
-
-	return result;
-}
-
-int main() try
-{
-	if (SDL_Init(SDL_INIT_VIDEO) != 0)
-		sdl2_fail("SDL_Init: ");
-
-	SDL_Window * window = SDL_CreateWindow("Graphics course practice 2",
-		SDL_WINDOWPOS_CENTERED,
-		SDL_WINDOWPOS_CENTERED,
-		800, 600,
-		SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE | SDL_WINDOW_MAXIMIZED);
-
-	if (!window)
-		sdl2_fail("SDL_CreateWindow: ");
-
-	int width, height;
-	SDL_GetWindowSize(window, &width, &height);
-
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
-	SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
-
-	SDL_GLContext gl_context = SDL_GL_CreateContext(window);
-	if (!gl_context)
-		sdl2_fail("SDL_GL_CreateContext: ");
+	program_cache shader_cache;
+	program_compiler shader_compiler(shader_cache);
+	// Benchmarks measure fixed shaders, only interactive runs watch them
+	std::optional<file_watcher> watcher;
+	if (!headless)
+		watcher.emplace();
+	program_library shaders(shader_compiler, PRACTICE_SHADER_DIR, watcher ? &*watcher : nullptr);
+	auto program_handle = shaders.add("triangle.vert", "triangle.frag");
 
-	if (auto result = glewInit(); result != GLEW_NO_ERROR)
-		glew_fail("glewInit: ", result);
+	gl_vertex_array vao;
 
-	if (!GLEW_VERSION_3_3)
-		throw std::runtime_error("OpenGL 3.3 is not supported");
+	// Waits for the first build
+	shaders.get(program_handle);
 
-	glClearColor(0.8f, 0.8f, 1.f, 0.f);
-
-	GLuint vertex_shader = create_shader(GL_VERTEX_SHADER, vertex_shader_source);
-	GLuint fragment_shader = create_shader(GL_FRAGMENT_SHADER, fragment_shader_source);
-
-	GLuint program = create_program(vertex_shader, fragment_shader);
-
-	GLuint vao;
-	glGenVertexArrays(1, &vao);
+	// Created after the setup above, which binds objects directly
+	gl_state state;
 
 	auto last_frame_start = std::chrono::high_resolution_clock::now();
 
 	bool running = true;
 	while (running)
 	{
+		if (!headless)
+			pacer.begin_frame();
+
 		for (SDL_Event event; SDL_PollEvent(&event);) switch (event.type)
 		{
 		case SDL_QUIT:
@@ -164,21 +91,40 @@ int main() try
 		if (!running)
 			break;
 
+		if (watcher && shaders.reload(state, watcher->changes()))
+			pacer.invalidate();
+
 		auto now = std::chrono::high_resolution_clock::now();
 		float dt = std::chrono::duration_cast<std::chrono::duration<float>>(now - last_frame_start).count();
 		last_frame_start = now;
 
+		profiler.end_frame(dt);
+		profiler.update_overlay(window);
+
+		scoped_timer draw_timer(draw_section);
+		if (headless)
+			headless->begin_frame();
+		profiler.begin_gpu();
 		glClear(GL_COLOR_BUFFER_BIT);
 
-		glUseProgram(program);
-		glBindVertexArray(vao);
+		state.use_program(shaders.get(program_handle));
+		state.bind_vertex_array(vao);
 		glDrawArrays(GL_TRIANGLES, 0, 3);
 
-		SDL_GL_SwapWindow(window);
+		profiler.end_gpu();
+		draw_timer.stop();
+
+		if (headless)
+			running = headless->end_frame();
+		else
+			pacer.present(window);
 	}
 
-	SDL_GL_DeleteContext(gl_context);
-	SDL_DestroyWindow(window);
+	if (headless)
+	{
+		headless->report(std::cout, profiler);
+		state.report(std::cout);
+	}
 }
 catch (std::exception const & e)
 {
@@ -0,0 +1,16 @@
+#version 330 core
+
+const vec2 VERTICES[3] = vec2[3](
+	vec2(0.0, 0.0),
+	vec2(1.0, 0.0),
+	vec2(0.0, 1.0)
+);
+
+out vec3 color;
+
+void main()
+{
+	vec2 position = VERTICES[gl_VertexID];
+	gl_Position = vec4(position, 0.0, 1.0);
+	color = vec3(position, 0.0);
+}
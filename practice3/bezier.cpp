@@ -0,0 +1,420 @@
+#include "bezier.h"
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define BEZIER_SSE 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define BEZIER_NEON 1
+#endif
+
+namespace
+{
+
+// Minimal 4-wide float vector, one lane per curve sample
+struct float4
+{
+#if defined(BEZIER_SSE)
+	__m128 v;
+
+	static float4 broadcast(float x) { return {_mm_set1_ps(x)}; }
+	static float4 load(float const * p) { return {_mm_loadu_ps(p)}; }
+	static float4 iota(float start, float step) { return {_mm_setr_ps(start, start + step, start + 2.f * step, start + 3.f * step)}; }
+
+	friend float4 operator + (float4 a, float4 b) { return {_mm_add_ps(a.v, b.v)}; }
+	friend float4 operator - (float4 a, float4 b) { return {_mm_sub_ps(a.v, b.v)}; }
+	friend float4 operator * (float4 a, float4 b) { return {_mm_mul_ps(a.v, b.v)}; }
+	friend float4 operator / (float4 a, float4 b) { return {_mm_div_ps(a.v, b.v)}; }
+
+	friend bool any_greater(float4 a, float4 b) { return _mm_movemask_ps(_mm_cmpgt_ps(a.v, b.v)) != 0; }
+	// Per lane, a > b ? x : y
+	static float4 select_greater(float4 a, float4 b, float4 x, float4 y)
+	{
+		__m128 mask = _mm_cmpgt_ps(a.v, b.v);
+		return {_mm_or_ps(_mm_and_ps(mask, x.v), _mm_andnot_ps(mask, y.v))};
+	}
+
+	// Writes lanes as four consecutive (x, y) pairs
+	static void store_interleaved(vec2 * out, float4 x, float4 y)
+	{
+		float * p = &out->x;
+		_mm_storeu_ps(p, _mm_unpacklo_ps(x.v, y.v));
+		_mm_storeu_ps(p + 4, _mm_unpackhi_ps(x.v, y.v));
+	}
+#elif defined(BEZIER_NEON)
+	float32x4_t v;
+
+	static float4 broadcast(float x) { return {vdupq_n_f32(x)}; }
+	static float4 load(float const * p) { return {vld1q_f32(p)}; }
+	static float4 iota(float start, float step)
+	{
+		float lanes[4] = {start, start + step, start + 2.f * step, start + 3.f * step};
+		return {vld1q_f32(lanes)};
+	}
+
+	friend float4 operator + (float4 a, float4 b) { return {vaddq_f32(a.v, b.v)}; }
+	friend float4 operator - (float4 a, float4 b) { return {vsubq_f32(a.v, b.v)}; }
+	friend float4 operator * (float4 a, float4 b) { return {vmulq_f32(a.v, b.v)}; }
+	friend float4 operator / (float4 a, float4 b)
+	{
+#if defined(__aarch64__) || defined(_M_ARM64)
+		return {vdivq_f32(a.v, b.v)};
+#else
+		// 32-bit NEON has no division
+		float lanes_a[4], lanes_b[4];
+		vst1q_f32(lanes_a, a.v);
+		vst1q_f32(lanes_b, b.v);
+		for (int i = 0; i < 4; ++i)
+			lanes_a[i] /= lanes_b[i];
+		return {vld1q_f32(lanes_a)};
+#endif
+	}
+
+	friend bool any_greater(float4 a, float4 b)
+	{
+		uint32x4_t mask = vcgtq_f32(a.v, b.v);
+		uint32x2_t half = vorr_u32(vget_low_u32(mask), vget_high_u32(mask));
+		return (vget_lane_u32(half, 0) | vget_lane_u32(half, 1)) != 0;
+	}
+	static float4 select_greater(float4 a, float4 b, float4 x, float4 y) { return {vbslq_f32(vcgtq_f32(a.v, b.v), x.v, y.v)}; }
+
+	static void store_interleaved(vec2 * out, float4 x, float4 y)
+	{
+		vst2q_f32(&out->x, float32x4x2_t{{x.v, y.v}});
+	}
+#else
+	float v[4];
+
+	static float4 broadcast(float x) { return {{x, x, x, x}}; }
+	static float4 load(float const * p) { return {{p[0], p[1], p[2], p[3]}}; }
+	static float4 iota(float start, float step) { return {{start, start + step, start + 2.f * step, start + 3.f * step}}; }
+
+	friend float4 operator + (float4 a, float4 b) { return {{a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3]}}; }
+	friend float4 operator - (float4 a, float4 b) { return {{a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3]}}; }
+	friend float4 operator * (float4 a, float4 b) { return {{a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3]}}; }
+	friend float4 operator / (float4 a, float4 b) { return {{a.v[0] / b.v[0], a.v[1] / b.v[1], a.v[2] / b.v[2], a.v[3] / b.v[3]}}; }
+
+	friend bool any_greater(float4 a, float4 b) { return a.v[0] > b.v[0] || a.v[1] > b.v[1] || a.v[2] > b.v[2] || a.v[3] > b.v[3]; }
+	static float4 select_greater(float4 a, float4 b, float4 x, float4 y)
+	{
+		float4 result;
+		for (int i = 0; i < 4; ++i)
+			result.v[i] = a.v[i] > b.v[i] ? x.v[i] : y.v[i];
+		return result;
+	}
+
+	static void store_interleaved(vec2 * out, float4 x, float4 y)
+	{
+		for (int i = 0; i < 4; ++i)
+			out[i] = {x.v[i], y.v[i]};
+	}
+#endif
+};
+
+// Bernstein form evaluated with nested multiplication:
+//   sum C(n,i) t^i (1-t)^(n-i) P_i = (...((P_0 u + C(n,1) t P_1) u + C(n,2) t^2 P_2) u ...) + t^n P_n
+// Unlike the power basis this stays stable over the whole [0, 1] range.
+// The weights are summed the same way and divide the result, which lets
+// both sums be rescaled before they overflow or underflow (see bezier.h)
+void evaluate4(vertex const * points, std::size_t count, float4 t, vec2 * out)
+{
+	std::size_t const n = count - 1;
+	float4 const one = float4::broadcast(1.f);
+	float4 const u = one - t;
+	float4 const high = float4::broadcast(bezier_rescale_high);
+	float4 const low = float4::broadcast(bezier_rescale_low);
+
+	float4 x = float4::broadcast(points[0].position.x);
+	float4 y = float4::broadcast(points[0].position.y);
+	float4 w = one;
+	float4 weights = one;
+	for (std::size_t i = 1; i <= n; ++i)
+	{
+		w = w * (t * float4::broadcast(float(n - i + 1) / float(i)));
+		x = x * u + w * float4::broadcast(points[i].position.x);
+		y = y * u + w * float4::broadcast(points[i].position.y);
+		weights = weights * u + w;
+		// Lanes are rescaled separately, so that one with a much smaller
+		// weight sum doesn't underflow
+		if (any_greater(weights, high) || any_greater(low, weights))
+		{
+			float4 scale = float4::select_greater(weights, high, low, float4::select_greater(low, weights, high, one));
+			w = w * scale;
+			x = x * scale;
+			y = y * scale;
+			weights = weights * scale;
+		}
+	}
+
+	float4::store_interleaved(out, x / weights, y / weights);
+}
+
+vec2 evaluate1(vertex const * points, std::size_t count, float t)
+{
+	std::size_t const n = count - 1;
+	float u = 1.f - t;
+	float x = points[0].position.x;
+	float y = points[0].position.y;
+	float w = 1.f;
+	float weights = 1.f;
+	for (std::size_t i = 1; i <= n; ++i)
+	{
+		w *= t * (float(n - i + 1) / float(i));
+		x = x * u + w * points[i].position.x;
+		y = y * u + w * points[i].position.y;
+		weights = weights * u + w;
+		if (weights > bezier_rescale_high || weights < bezier_rescale_low)
+		{
+			float scale = weights > bezier_rescale_high ? bezier_rescale_low : bezier_rescale_high;
+			w *= scale;
+			x *= scale;
+			y *= scale;
+			weights *= scale;
+		}
+	}
+	return {x / weights, y / weights};
+}
+
+// Cubic Bernstein basis: (1-t)^3, 3t(1-t)^2, 3t^2(1-t), t^3
+template <typename T>
+void cubic_basis(T t, T one, T three, T (&b)[4])
+{
+	T u = one - t;
+	T tt = t * t, uu = u * u;
+	b[0] = uu * u;
+	b[1] = three * t * uu;
+	b[2] = three * tt * u;
+	b[3] = tt * t;
+}
+
+}
+
+vec2 bezier(std::vector<vertex> const & vertices, float t)
+{
+	if (vertices.empty())
+		return {0.f, 0.f};
+	if (vertices.size() == 1)
+		return vertices[0].position;
+	return evaluate1(vertices.data(), vertices.size(), t);
+}
+
+void bezier(vertex const * points, std::size_t count, float const * ts, std::size_t sample_count, vec2 * out)
+{
+	if (count == 0)
+		return;
+	if (count == 1)
+	{
+		std::fill(out, out + sample_count, points[0].position);
+		return;
+	}
+
+	std::size_t i = 0;
+	for (; i + 4 <= sample_count; i += 4)
+		evaluate4(points, count, float4::load(ts + i), out + i);
+	for (; i < sample_count; ++i)
+		out[i] = evaluate1(points, count, ts[i]);
+}
+
+void bezier_uniform(vertex const * points, std::size_t count, std::size_t sample_count, vec2 * out)
+{
+	if (count == 0 || sample_count == 0)
+		return;
+	if (count == 1 || sample_count == 1)
+	{
+		std::fill(out, out + sample_count, points[0].position);
+		return;
+	}
+
+	float const step = 1.f / float(sample_count - 1);
+
+	std::size_t i = 0;
+	for (; i + 4 <= sample_count; i += 4)
+		evaluate4(points, count, float4::iota(float(i) * step, step), out + i);
+	for (; i < sample_count; ++i)
+		out[i] = evaluate1(points, count, float(i) * step);
+
+	// Keep the end point exact regardless of rounding in t
+	out[sample_count - 1] = points[count - 1].position;
+}
+
+vec2 fixed_bezier<3>::operator()(float t) const
+{
+	float b[4];
+	cubic_basis(t, 1.f, 3.f, b);
+	return {
+		b[0] * points[0].x + b[1] * points[1].x + b[2] * points[2].x + b[3] * points[3].x,
+		b[0] * points[0].y + b[1] * points[1].y + b[2] * points[2].y + b[3] * points[3].y,
+	};
+}
+
+void fixed_bezier<3>::evaluate(float const * ts, std::size_t sample_count, vec2 * out) const
+{
+	float4 const one = float4::broadcast(1.f), three = float4::broadcast(3.f);
+	float4 px[4], py[4];
+	for (int k = 0; k < 4; ++k)
+	{
+		px[k] = float4::broadcast(points[k].x);
+		py[k] = float4::broadcast(points[k].y);
+	}
+
+	std::size_t i = 0;
+	for (; i + 4 <= sample_count; i += 4)
+	{
+		float4 b[4];
+		cubic_basis(float4::load(ts + i), one, three, b);
+		float4 x = b[0] * px[0] + b[1] * px[1] + b[2] * px[2] + b[3] * px[3];
+		float4 y = b[0] * py[0] + b[1] * py[1] + b[2] * py[2] + b[3] * py[3];
+		float4::store_interleaved(out + i, x, y);
+	}
+	for (; i < sample_count; ++i)
+		out[i] = (*this)(ts[i]);
+}
+
+void fixed_bezier<3>::evaluate_uniform(std::size_t sample_count, vec2 * out) const
+{
+	if (sample_count == 0)
+		return;
+	if (sample_count == 1)
+	{
+		out[0] = points[0];
+		return;
+	}
+
+	// Power basis coefficients: P(t) = a t^3 + b t^2 + c t + d
+	auto coefficients = [](float p0, float p1, float p2, float p3, float h, float (&f)[4])
+	{
+		float a = -p0 + 3.f * p1 - 3.f * p2 + p3;
+		float b = 3.f * (p0 - 2.f * p1 + p2);
+		float c = 3.f * (p1 - p0);
+		float h2 = h * h, h3 = h2 * h;
+		// Value and first three forward differences at t = 0
+		f[0] = p0;
+		f[1] = a * h3 + b * h2 + c * h;
+		f[2] = 6.f * a * h3 + 2.f * b * h2;
+		f[3] = 6.f * a * h3;
+	};
+
+	float const h = 1.f / float(sample_count - 1);
+	float fx[4], fy[4];
+	coefficients(points[0].x, points[1].x, points[2].x, points[3].x, h, fx);
+	coefficients(points[0].y, points[1].y, points[2].y, points[3].y, h, fy);
+
+	for (std::size_t i = 0; i + 1 < sample_count; ++i)
+	{
+		out[i] = {fx[0], fy[0]};
+		fx[0] += fx[1]; fx[1] += fx[2]; fx[2] += fx[3];
+		fy[0] += fy[1]; fy[1] += fy[2]; fy[2] += fy[3];
+	}
+	out[sample_count - 1] = points[3];
+}
+
+namespace
+{
+
+struct screen_mapping
+{
+	float const * view;
+	float half_width;
+	float half_height;
+
+	vec2 operator()(vec2 p) const
+	{
+		float x = view[0] * p.x + view[1] * p.y + view[3];
+		float y = view[4] * p.x + view[5] * p.y + view[7];
+		float w = view[12] * p.x + view[13] * p.y + view[15];
+		return {x / w * half_width, y / w * half_height};
+	}
+};
+
+bool flat_enough(vec2 const * piece, std::size_t count, screen_mapping const & to_screen, float tolerance)
+{
+	vec2 a = to_screen(piece[0]);
+	vec2 b = to_screen(piece[count - 1]);
+	float dx = b.x - a.x, dy = b.y - a.y;
+	float length2 = dx * dx + dy * dy;
+	float tolerance2 = tolerance * tolerance;
+
+	for (std::size_t i = 1; i + 1 < count; ++i)
+	{
+		vec2 p = to_screen(piece[i]);
+		float px = p.x - a.x, py = p.y - a.y;
+		float distance2;
+		if (length2 > 0.f)
+		{
+			float cross = px * dy - py * dx;
+			distance2 = cross * cross / length2;
+		}
+		else
+			distance2 = px * px + py * py;
+
+		if (distance2 > tolerance2)
+			return false;
+	}
+	return true;
+}
+
+// Splits `piece` at t = 1/2 into `left` and `right`, using `scratch` (count points)
+void split_half(vec2 const * piece, std::size_t count, vec2 * left, vec2 * right, vec2 * scratch)
+{
+	std::copy(piece, piece + count, scratch);
+	for (std::size_t k = 0; k < count; ++k)
+	{
+		left[k] = scratch[0];
+		right[count - 1 - k] = scratch[count - 1 - k];
+		for (std::size_t i = 0; i + k + 1 < count; ++i)
+		{
+			scratch[i].x = (scratch[i].x + scratch[i + 1].x) * 0.5f;
+			scratch[i].y = (scratch[i].y + scratch[i + 1].y) * 0.5f;
+		}
+	}
+}
+
+}
+
+void adaptive_bezier::tessellate(vertex const * points, std::size_t count, float const * view, int width, int height,
+	float tolerance, std::vector<vec2> & out)
+{
+	out.clear();
+	if (count == 0)
+		return;
+	if (count == 1)
+	{
+		out.push_back(points[0].position);
+		return;
+	}
+
+	screen_mapping const to_screen{view, 0.5f * width, 0.5f * height};
+
+	stack_.resize(count * (max_depth + 2));
+	depths_.resize(max_depth + 2);
+	scratch_.resize(count);
+
+	for (std::size_t i = 0; i < count; ++i)
+		stack_[i] = points[i].position;
+	depths_[0] = 0;
+	std::size_t top = 1;
+
+	// Depth-first, left half first, so pieces come out in curve order;
+	// only the start of every accepted piece is emitted
+	while (top > 0)
+	{
+		vec2 * piece = stack_.data() + (top - 1) * count;
+		int depth = depths_[top - 1];
+
+		if (depth >= max_depth || flat_enough(piece, count, to_screen, tolerance))
+		{
+			out.push_back(piece[0]);
+			--top;
+			continue;
+		}
+
+		// The right half replaces the current piece, the left one goes on top
+		vec2 * left = piece + count;
+		split_half(piece, count, left, piece, scratch_.data());
+		depths_[top - 1] = depth + 1;
+		depths_[top] = depth + 1;
+		++top;
+	}
+
+	out.push_back(points[count - 1].position);
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include "vertex.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+// Bezier curve evaluation. Every function here writes into caller-provided
+// storage and never allocates; samples are evaluated four at a time in SIMD
+// lanes using the Bernstein form with Horner-like nested multiplication,
+// which is O(n) per sample instead of the O(n^2) of De Casteljau.
+//
+// The binomial coefficients alone overflow a float from about 130 control
+// points on, so the sum is accumulated together with the sum of its weights
+// and divided by it at the end. The weight sum rises far above 1 around the
+// middle of the curve and returns to it at the end, so both sums are scaled
+// by 2^-64 or 2^64 whenever it leaves [2^-64, 2^64]; with that, any number
+// of control points works. shaders/bezier.vert evaluates the same
+// recurrence.
+
+// Bounds of the weight sum, 2^64 and 2^-64, which are also the factors the
+// running sums are rescaled by when it goes past them
+constexpr float bezier_rescale_high = 0x1p64f;
+constexpr float bezier_rescale_low = 0x1p-64f;
+
+// Single sample of the curve defined by all `vertices`
+vec2 bezier(std::vector<vertex> const & vertices, float t);
+
+// Evaluates the curve with `count` control points at `ts[0..sample_count)` into `out`
+void bezier(vertex const * points, std::size_t count, float const * ts, std::size_t sample_count, vec2 * out);
+
+// Evaluates the curve at `sample_count` uniformly spaced t values in [0, 1]
+// (both ends included) into `out`
+void bezier_uniform(vertex const * points, std::size_t count, std::size_t sample_count, vec2 * out);
+
+// Curve of a compile-time degree; the generic version has its Bernstein
+// loop fully unrolled by the compiler, cubic curves are specialized below
+template <std::size_t Degree>
+struct fixed_bezier
+{
+	vec2 points[Degree + 1];
+
+	vec2 operator()(float t) const
+	{
+		float u = 1.f - t;
+		// C(Degree, i) t^i, and the sums of the terms and of their weights
+		float w = 1.f;
+		vec2 acc = points[0];
+		float weights = 1.f;
+		for (std::size_t i = 1; i <= Degree; ++i)
+		{
+			w *= t * (float(Degree - i + 1) / float(i));
+			acc.x = acc.x * u + w * points[i].x;
+			acc.y = acc.y * u + w * points[i].y;
+			weights = weights * u + w;
+			// The weight sum stays within [2^-Degree, 2^Degree]
+			if (Degree > 64 && (weights > bezier_rescale_high || weights < bezier_rescale_low))
+			{
+				float scale = weights > bezier_rescale_high ? bezier_rescale_low : bezier_rescale_high;
+				w *= scale;
+				acc.x *= scale;
+				acc.y *= scale;
+				weights *= scale;
+			}
+		}
+		return {acc.x / weights, acc.y / weights};
+	}
+
+	void evaluate(float const * ts, std::size_t sample_count, vec2 * out) const
+	{
+		for (std::size_t i = 0; i < sample_count; ++i)
+			out[i] = (*this)(ts[i]);
+	}
+
+	void evaluate_uniform(std::size_t sample_count, vec2 * out) const
+	{
+		float step = (sample_count > 1) ? 1.f / float(sample_count - 1) : 0.f;
+		for (std::size_t i = 0; i < sample_count; ++i)
+			out[i] = (*this)(float(i) * step);
+	}
+};
+
+template <>
+struct fixed_bezier<0>
+{
+	vec2 points[1];
+
+	vec2 operator()(float) const { return points[0]; }
+	void evaluate(float const *, std::size_t sample_count, vec2 * out) const { std::fill(out, out + sample_count, points[0]); }
+	void evaluate_uniform(std::size_t sample_count, vec2 * out) const { std::fill(out, out + sample_count, points[0]); }
+};
+
+// Cubic curves use explicit Bernstein polynomials in SIMD lanes, and
+// forward differencing (three additions per sample) for uniform steps
+template <>
+struct fixed_bezier<3>
+{
+	vec2 points[4];
+
+	vec2 operator()(float t) const;
+	void evaluate(float const * ts, std::size_t sample_count, vec2 * out) const;
+	void evaluate_uniform(std::size_t sample_count, vec2 * out) const;
+};
+
+using cubic_bezier = fixed_bezier<3>;
+
+// Adaptive tessellation by recursive De Casteljau splitting at t = 1/2.
+// A piece is accepted once every control point lies within `tolerance`
+// pixels of its chord after applying `view` (the row-major matrix given to
+// the shader) and the width x height viewport transform; by the convex hull
+// property this bounds the on-screen error of the resulting polyline.
+// The object keeps its work buffers, so re-tessellating doesn't allocate.
+class adaptive_bezier
+{
+public:
+	// Replaces `out` with the polyline approximating the curve, in the same
+	// space as the control points, both end points included
+	void tessellate(vertex const * points, std::size_t count, float const * view, int width, int height,
+		float tolerance, std::vector<vec2> & out);
+
+	static constexpr int max_depth = 16;
+
+private:
+	// Pending pieces, (count) control points each, and their split depth
+	std::vector<vec2> stack_;
+	std::vector<int> depths_;
+	std::vector<vec2> scratch_;
+};
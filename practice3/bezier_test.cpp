@@ -0,0 +1,116 @@
+#include "bezier.h"
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+// Checks the Bernstein evaluation against De Casteljau in double precision,
+// up to degrees where the binomial coefficients no longer fit in a float
+
+namespace
+{
+
+vec2 de_casteljau(std::vector<vertex> const & points, double t)
+{
+	std::vector<double> x(points.size()), y(points.size());
+	for (std::size_t i = 0; i < points.size(); ++i)
+	{
+		x[i] = points[i].position.x;
+		y[i] = points[i].position.y;
+	}
+	for (std::size_t k = points.size() - 1; k > 0; --k)
+	{
+		for (std::size_t i = 0; i < k; ++i)
+		{
+			x[i] = x[i] * (1.0 - t) + x[i + 1] * t;
+			y[i] = y[i] * (1.0 - t) + y[i + 1] * t;
+		}
+	}
+	return {float(x[0]), float(y[0])};
+}
+
+// Control points are within [-1, 1], so errors are absolute. Rounding
+// 1 - t to a float alone is off by up to 2^-24 relative, which the u^n
+// factors of the Bernstein form (and the n levels of a float De Casteljau)
+// grow linearly with the degree
+float tolerance(std::size_t count)
+{
+	return 1e-5f + float(count) * 1e-7f;
+}
+
+int failures = 0;
+
+void check(char const * what, std::size_t count, float t, vec2 actual, vec2 expected)
+{
+	float error = std::max(std::abs(actual.x - expected.x), std::abs(actual.y - expected.y));
+	if (!(error <= tolerance(count)))
+	{
+		if (++failures <= 10)
+			std::printf("%s: %zu points, t = %g: (%g, %g) instead of (%g, %g)\n", what, count, t,
+				actual.x, actual.y, expected.x, expected.y);
+	}
+}
+
+template <std::size_t Degree>
+void check_fixed(std::vector<vertex> const & points, std::vector<float> const & ts)
+{
+	fixed_bezier<Degree> curve;
+	for (std::size_t i = 0; i <= Degree; ++i)
+		curve.points[i] = points[i].position;
+	for (float t : ts)
+		check("fixed_bezier", Degree + 1, t, curve(t), de_casteljau(points, t));
+}
+
+}
+
+int main()
+{
+	std::mt19937 rng(7);
+	std::uniform_real_distribution<float> coordinate(-1.f, 1.f);
+
+	std::vector<float> ts;
+	for (int i = 0; i <= 100; ++i)
+		ts.push_back(float(i) / 100.f);
+	for (float t : {1e-6f, 1e-3f, 0.4999f, 0.999f, 0.999999f})
+		ts.push_back(t);
+	// Keep the SIMD path covering every t
+	while (ts.size() % 4 != 0)
+		ts.push_back(0.5f);
+
+	for (std::size_t count : {2, 3, 4, 10, 64, 65, 100, 129, 130, 200, 1000, 2000})
+	{
+		std::vector<vertex> points(count);
+		for (auto & p : points)
+			p.position = {coordinate(rng), coordinate(rng)};
+
+		std::vector<vec2> out(ts.size());
+		bezier(points.data(), count, ts.data(), ts.size(), out.data());
+		for (std::size_t i = 0; i < ts.size(); ++i)
+		{
+			vec2 expected = de_casteljau(points, ts[i]);
+			check("bezier", count, ts[i], out[i], expected);
+			check("bezier (single)", count, ts[i], bezier(points, ts[i]), expected);
+		}
+
+		std::size_t const samples = 257;
+		out.resize(samples);
+		bezier_uniform(points.data(), count, samples, out.data());
+		float const step = 1.f / float(samples - 1);
+		for (std::size_t i = 0; i < samples; ++i)
+			check("bezier_uniform", count, float(i) * step, out[i], de_casteljau(points, float(i) * step));
+
+		if (count == 200)
+			check_fixed<199>(points, ts);
+		if (count == 4)
+			check_fixed<3>(points, ts);
+	}
+
+	if (failures > 0)
+	{
+		std::printf("%d samples don't match De Casteljau\n", failures);
+		return 1;
+	}
+	std::printf("All samples match De Casteljau\n");
+	return 0;
+}
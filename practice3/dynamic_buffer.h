@@ -0,0 +1,113 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include "gl_object.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+// Vertex buffer with a CPU-side shadow copy that tracks which span has
+// changed since the last flush(). Only that span is sent with
+// glBufferSubData; the GPU storage grows by doubling, so appending one
+// element at a time doesn't reallocate it on every edit.
+template <typename T>
+class dynamic_buffer
+{
+public:
+	explicit dynamic_buffer(GLenum target = GL_ARRAY_BUFFER, GLenum usage = GL_DYNAMIC_DRAW)
+		: target_(target)
+		, usage_(usage)
+	{}
+
+	GLuint id() const { return buffer_; }
+
+	std::size_t size() const { return items_.size(); }
+	bool empty() const { return items_.empty(); }
+	T const * data() const { return items_.data(); }
+	T const & operator[](std::size_t i) const { return items_[i]; }
+	T const & back() const { return items_.back(); }
+
+	void push_back(T const & value)
+	{
+		items_.push_back(value);
+		mark(items_.size() - 1, items_.size());
+	}
+
+	// Shrinking never needs an upload, the tail is simply not drawn
+	void pop_back()
+	{
+		items_.pop_back();
+		dirty_end_ = std::min(dirty_end_, items_.size());
+		dirty_begin_ = std::min(dirty_begin_, dirty_end_);
+	}
+
+	void clear()
+	{
+		items_.clear();
+		dirty_begin_ = dirty_end_ = 0;
+	}
+
+	void set(std::size_t i, T const & value)
+	{
+		items_[i] = value;
+		mark(i, i + 1);
+	}
+
+	// Resizes and returns the storage for the caller to overwrite entirely
+	T * assign(std::size_t count)
+	{
+		items_.resize(count);
+		mark(0, count);
+		return items_.data();
+	}
+
+	// Uploads the dirty span (or everything, if the GPU storage had to grow);
+	// leaves the buffer bound to its target. Returns the number of bytes sent.
+	std::size_t flush()
+	{
+		std::size_t uploaded = 0;
+		if (items_.size() > capacity_)
+		{
+			capacity_ = std::max({items_.size(), 2 * capacity_, std::size_t(16)});
+			glBindBuffer(target_, buffer_);
+			glBufferData(target_, capacity_ * sizeof(T), nullptr, usage_);
+			glBufferSubData(target_, 0, items_.size() * sizeof(T), items_.data());
+			uploaded = items_.size() * sizeof(T);
+		}
+		else if (dirty_begin_ < dirty_end_)
+		{
+			glBindBuffer(target_, buffer_);
+			glBufferSubData(target_, dirty_begin_ * sizeof(T), (dirty_end_ - dirty_begin_) * sizeof(T), items_.data() + dirty_begin_);
+			uploaded = (dirty_end_ - dirty_begin_) * sizeof(T);
+		}
+		dirty_begin_ = dirty_end_ = 0;
+		return uploaded;
+	}
+
+	bool dirty() const { return dirty_begin_ < dirty_end_; }
+
+private:
+	GLenum target_;
+	GLenum usage_;
+	gl_buffer buffer_;
+	std::size_t capacity_ = 0;
+	std::vector<T> items_;
+	std::size_t dirty_begin_ = 0;
+	std::size_t dirty_end_ = 0;
+
+	void mark(std::size_t begin, std::size_t end)
+	{
+		if (dirty_begin_ == dirty_end_)
+		{
+			dirty_begin_ = begin;
+			dirty_end_ = end;
+		}
+		else
+		{
+			dirty_begin_ = std::min(dirty_begin_, begin);
+			dirty_end_ = std::max(dirty_end_, end);
+		}
+	}
+};
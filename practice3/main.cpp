@@ -12,163 +12,144 @@
 #include <iostream>
 #include <chrono>
 #include <vector>
-
-std::string to_string(std::string_view str)
-{
-	return std::string(str.begin(), str.end());
-}
-
-void sdl2_fail(std::string_view message)
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include "bezier.h"
+#include "dynamic_buffer.h"
+#include "gl_window.h"
+#include "error.h"
+#include "shader.h"
+#include "program_cache.h"
+#include "program_compiler.h"
+#include "program_library.h"
+#include "file_watcher.h"
+#include "profiler.h"
+#include "gl_state.h"
+#include "benchmark.h"
+#include "frame_pacer.h"
+
+int main(int argc, char ** argv) try
 {
-	throw std::runtime_error(to_string(message) + SDL_GetError());
-}
-
-void glew_fail(std::string_view message, GLenum error)
-{
-	throw std::runtime_error(to_string(message) + reinterpret_cast<const char *>(glewGetErrorString(error)));
-}
-
-const char vertex_shader_source[] =
-R"(#version 330 core
-
-uniform mat4 view;
-
-layout (location = 0) in vec2 in_position;
-layout (location = 1) in vec4 in_color;
+	std::vector<std::string_view> args;
+	auto options = parse_benchmark_options(argc, argv, &args);
 
-out vec4 color;
-
-void main()
-{
-	gl_Position = view * vec4(in_position, 0.0, 1.0);
-	color = in_color;
-}
-)";
+	bool gpu_tessellation = false;
+	bool adaptive_tessellation = false;
+	for (auto arg : args)
+	{
+		if (arg == "--gpu")
+			gpu_tessellation = true;
+		else if (arg == "--adaptive")
+			adaptive_tessellation = true;
+		else
+			throw std::runtime_error("Unknown argument: " + to_string(arg));
+	}
 
-const char fragment_shader_source[] =
-R"(#version 330 core
+	gl_window window("Graphics course practice 3", options.window_flags(), {.samples = 4});
+	frame_pacer pacer(options.pacing);
 
-in vec4 color;
+	int width = window.width(), height = window.height();
 
-layout (location = 0) out vec4 out_color;
+	glClearColor(0.8f, 0.8f, 1.f, 0.f);
 
-void main()
-{
-	out_color = color;
-}
-)";
+	frame_profiler profiler("Graphics course practice 3");
+	auto & draw_section = profiler.cpu_section("draw");
 
-GLuint create_shader(GLenum type, const char * source)
-{
-	GLuint result = glCreateShader(type);
-	glShaderSource(result, 1, &source, nullptr);
-	glCompileShader(result);
-	GLint status;
-	glGetShaderiv(result, GL_COMPILE_STATUS, &status);
-	if (status != GL_TRUE)
+	std::unique_ptr<benchmark> headless;
+	if (options.headless)
 	{
-		GLint info_log_length;
-		glGetShaderiv(result, GL_INFO_LOG_LENGTH, &info_log_length);
-		std::string info_log(info_log_length, '\0');
-		glGetShaderInfoLog(result, info_log.size(), nullptr, info_log.data());
-		throw std::runtime_error("Shader compilation failed: " + info_log);
+		headless = std::make_unique<benchmark>(options, "practice3");
+		width = headless->width();
+		height = headless->height();
 	}
-	return result;
-}
 
-GLuint create_program(GLuint vertex_shader, GLuint fragment_shader)
-{
-	GLuint result = glCreateProgram();
-	glAttachShader(result, vertex_shader);
-	glAttachShader(result, fragment_shader);
-	glLinkProgram(result);
-
-	GLint status;
-	glGetProgramiv(result, GL_LINK_STATUS, &status);
-	if (status != GL_TRUE)
+	// Both programs compile while the buffers below are set up
+	program_cache shader_cache;
+	program_compiler shader_compiler(shader_cache);
+	// Benchmarks measure fixed shaders, only interactive runs watch them
+	std::optional<file_watcher> watcher;
+	if (!headless)
+		watcher.emplace();
+	program_library shaders(shader_compiler, PRACTICE_SHADER_DIR, watcher ? &*watcher : nullptr);
+
+	// Looked up again whenever a program is rebuilt
+	GLint view_location = -1;
+	GLint bezier_view_location = -1;
+	GLint bezier_control_points_location = -1;
+	GLint bezier_vertex_stride_location = -1;
+	GLint bezier_point_count_location = -1;
+	GLint bezier_segments_location = -1;
+	GLint bezier_curve_color_location = -1;
+
+	auto program_handle = shaders.add("polyline.vert", "color.frag", [&](gl_program const & program)
 	{
-		GLint info_log_length;
-		glGetProgramiv(result, GL_INFO_LOG_LENGTH, &info_log_length);
-		std::string info_log(info_log_length, '\0');
-		glGetProgramInfoLog(result, info_log.size(), nullptr, info_log.data());
-		throw std::runtime_error("Program linkage failed: " + info_log);
-	}
-
-	return result;
-}
-
-struct vec2
-{
-	float x;
-	float y;
-};
-
-struct vertex
-{
-	vec2 position;
-	std::uint8_t color[4];
-};
-
-vec2 bezier(std::vector<vertex> const & vertices, float t)
-{
-	std::vector<vec2> points(vertices.size());
-
-	for (std::size_t i = 0; i < vertices.size(); ++i)
-		points[i] = vertices[i].position;
-
-	// De Casteljau's algorithm
-	for (std::size_t k = 0; k + 1 < vertices.size(); ++k) {
-		for (std::size_t i = 0; i + k + 1 < vertices.size(); ++i) {
-			points[i].x = points[i].x * (1.f - t) + points[i + 1].x * t;
-			points[i].y = points[i].y * (1.f - t) + points[i + 1].y * t;
+		view_location = program.uniform("view");
+	});
+	auto bezier_program_handle = shaders.add("bezier.vert", "color.frag", [&](gl_program const & program)
+	{
+		bezier_view_location = program.uniform("view");
+		bezier_control_points_location = program.uniform("control_points");
+		bezier_vertex_stride_location = program.uniform("vertex_stride");
+		bezier_point_count_location = program.uniform("point_count");
+		bezier_segments_location = program.uniform("segments");
+		bezier_curve_color_location = program.uniform("curve_color");
+	});
+
+	// Edits only upload the changed span of these buffers
+	dynamic_buffer<vertex> vertices;
+	dynamic_buffer<vec2> curve;
+	std::vector<vec2> adaptive_curve;
+	int quality = 4;
+	adaptive_bezier tessellator;
+	bool vertices_changed = false;
+	bool curve_changed = false;
+
+	gl_vertex_array vertices_vao;
+	glBindVertexArray(vertices_vao);
+	glBindBuffer(GL_ARRAY_BUFFER, vertices.id());
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(vertex), (void *) (offsetof(vertex, position)));
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(vertex), (void *) (offsetof(vertex, color)));
+
+	// CPU-tessellated curve points; their color comes from a constant attribute
+	gl_vertex_array curve_vao;
+	glBindVertexArray(curve_vao);
+	glBindBuffer(GL_ARRAY_BUFFER, curve.id());
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(vec2), (void *) 0);
+
+	// The GPU path has no vertex inputs at all, points come from gl_VertexID
+	gl_vertex_array bezier_vao;
+
+	static_assert(sizeof(vertex) % sizeof(float) == 0);
+	gl_texture control_points_texture;
+	glBindTexture(GL_TEXTURE_BUFFER, control_points_texture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_R32F, vertices.id());
+
+	glPointSize(10.f);
+
+	// Waits for the first builds
+	shaders.get(program_handle);
+	shaders.get(bezier_program_handle);
+
+	// There is no mouse input in headless runs, so the curve gets
+	// a fixed zig-zag of `--scene` control points instead
+	if (headless)
+	{
+		int const point_count = options.scene_size > 0 ? options.scene_size : 8;
+		for (int i = 0; i < point_count; ++i)
+		{
+			float x = width * (i + 0.5f) / point_count;
+			float y = height * (i % 2 == 0 ? 0.25f : 0.75f);
+			vertices.push_back({{x, y}, {0, 0, 0, 255}});
 		}
+		vertices_changed = true;
 	}
-	return points[0];
-}
-
-int main() try
-{
-	if (SDL_Init(SDL_INIT_VIDEO) != 0)
-		sdl2_fail("SDL_Init: ");
-
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
-	SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
-	SDL_GL_SetAttribute(SDL_GL_MULTISAMPLEBUFFERS, 1);
-	SDL_GL_SetAttribute(SDL_GL_MULTISAMPLESAMPLES, 4);
-
-	SDL_Window * window = SDL_CreateWindow("Graphics course practice 3",
-		SDL_WINDOWPOS_CENTERED,
-		SDL_WINDOWPOS_CENTERED,
-		800, 600,
-		SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE | SDL_WINDOW_MAXIMIZED);
-
-	if (!window)
-		sdl2_fail("SDL_CreateWindow: ");
 
-	int width, height;
-	SDL_GetWindowSize(window, &width, &height);
-
-	SDL_GLContext gl_context = SDL_GL_CreateContext(window);
-	if (!gl_context)
-		sdl2_fail("SDL_GL_CreateContext: ");
-
-	SDL_GL_SetSwapInterval(0);
-
-	if (auto result = glewInit(); result != GLEW_NO_ERROR)
-		glew_fail("glewInit: ", result);
-
-	if (!GLEW_VERSION_3_3)
-		throw std::runtime_error("OpenGL 3.3 is not supported");
-
-	glClearColor(0.8f, 0.8f, 1.f, 0.f);
-
-	auto vertex_shader = create_shader(GL_VERTEX_SHADER, vertex_shader_source);
-	auto fragment_shader = create_shader(GL_FRAGMENT_SHADER, fragment_shader_source);
-	auto program = create_program(vertex_shader, fragment_shader);
-
-	GLuint view_location = glGetUniformLocation(program, "view");
+	// Created after the setup above, which binds objects directly
+	gl_state state;
 
 	auto last_frame_start = std::chrono::high_resolution_clock::now();
 
@@ -177,6 +158,9 @@ int main() try
 	bool running = true;
 	while (running)
 	{
+		if (!headless)
+			pacer.begin_frame();
+
 		for (SDL_Event event; SDL_PollEvent(&event);) switch (event.type)
 		{
 		case SDL_QUIT:
@@ -188,6 +172,7 @@ int main() try
 				width = event.window.data1;
 				height = event.window.data2;
 				glViewport(0, 0, width, height);
+				curve_changed = true;
 				break;
 			}
 			break;
@@ -196,20 +181,41 @@ int main() try
 			{
 				int mouse_x = event.button.x;
 				int mouse_y = event.button.y;
+				vertices.push_back({{float(mouse_x), float(mouse_y)}, {0, 0, 0, 255}});
+				vertices_changed = true;
 			}
 			else if (event.button.button == SDL_BUTTON_RIGHT)
 			{
-
+				if (!vertices.empty())
+				{
+					vertices.pop_back();
+					vertices_changed = true;
+				}
 			}
 			break;
 		case SDL_KEYDOWN:
 			if (event.key.keysym.sym == SDLK_LEFT)
 			{
-
+				if (quality > 1)
+				{
+					--quality;
+					curve_changed = true;
+				}
 			}
 			else if (event.key.keysym.sym == SDLK_RIGHT)
 			{
-
+				++quality;
+				curve_changed = true;
+			}
+			else if (event.key.keysym.sym == SDLK_g)
+			{
+				gpu_tessellation = !gpu_tessellation;
+				curve_changed = true;
+			}
+			else if (event.key.keysym.sym == SDLK_a)
+			{
+				adaptive_tessellation = !adaptive_tessellation;
+				curve_changed = true;
 			}
 			break;
 		}
@@ -217,29 +223,105 @@ int main() try
 		if (!running)
 			break;
 
+		if (watcher && shaders.reload(state, watcher->changes()))
+			pacer.invalidate();
+
 		auto now = std::chrono::high_resolution_clock::now();
 		float dt = std::chrono::duration_cast<std::chrono::duration<float>>(now - last_frame_start).count();
 		last_frame_start = now;
-		time += dt;
+		time += headless ? benchmark::time_step : dt;
 
-		glClear(GL_COLOR_BUFFER_BIT);
+		profiler.end_frame(dt);
+		profiler.update_overlay(window);
+
+		if (vertices_changed)
+		{
+			vertices.flush();
+			curve_changed = true;
+			vertices_changed = false;
+		}
 
+		// Maps window pixel coordinates to NDC
 		float view[16] =
 		{
-			1.f, 0.f, 0.f, 0.f,
-			0.f, 1.f, 0.f, 0.f,
+			2.f / width, 0.f, 0.f, -1.f,
+			0.f, -2.f / height, 0.f, 1.f,
 			0.f, 0.f, 1.f, 0.f,
 			0.f, 0.f, 0.f, 1.f,
 		};
 
-		glUseProgram(program);
+		// Keep the workload fixed: headless runs tessellate on every frame
+		if (headless)
+			curve_changed = true;
+
+		int const segments = std::max<int>(1, (vertices.size() - 1) * quality);
+
+		if (curve_changed && !gpu_tessellation && vertices.size() >= 2)
+		{
+			if (adaptive_tessellation)
+			{
+				// In adaptive mode quality controls the allowed on-screen error instead
+				float const tolerance = 2.f / quality;
+				tessellator.tessellate(vertices.data(), vertices.size(), view, width, height, tolerance, adaptive_curve);
+				std::copy(adaptive_curve.begin(), adaptive_curve.end(), curve.assign(adaptive_curve.size()));
+			}
+			else
+				bezier_uniform(vertices.data(), vertices.size(), segments + 1, curve.assign(segments + 1));
+			curve.flush();
+		}
+		curve_changed = false;
+
+		scoped_timer draw_timer(draw_section);
+		if (headless)
+			headless->begin_frame();
+		profiler.begin_gpu();
+		glClear(GL_COLOR_BUFFER_BIT);
+
+		state.use_program(shaders.get(program_handle));
 		glUniformMatrix4fv(view_location, 1, GL_TRUE, view);
 
-		SDL_GL_SwapWindow(window);
+		state.bind_vertex_array(vertices_vao);
+		glDrawArrays(GL_LINE_STRIP, 0, vertices.size());
+		glDrawArrays(GL_POINTS, 0, vertices.size());
+
+		if (vertices.size() >= 2)
+		{
+			if (gpu_tessellation)
+			{
+				state.use_program(shaders.get(bezier_program_handle));
+				glUniformMatrix4fv(bezier_view_location, 1, GL_TRUE, view);
+				glUniform1i(bezier_control_points_location, 0);
+				glUniform1i(bezier_vertex_stride_location, sizeof(vertex) / sizeof(float));
+				glUniform1i(bezier_point_count_location, vertices.size());
+				glUniform1i(bezier_segments_location, segments);
+				glUniform4f(bezier_curve_color_location, 1.f, 0.f, 0.f, 1.f);
+
+				state.bind_texture(0, GL_TEXTURE_BUFFER, control_points_texture);
+				state.bind_vertex_array(bezier_vao);
+				glDrawArrays(GL_LINE_STRIP, 0, segments + 1);
+			}
+			else
+			{
+				glVertexAttrib4f(1, 1.f, 0.f, 0.f, 1.f);
+				state.bind_vertex_array(curve_vao);
+				glDrawArrays(GL_LINE_STRIP, 0, curve.size());
+			}
+		}
+
+		profiler.end_gpu();
+		draw_timer.stop();
+
+		if (headless)
+			running = headless->end_frame();
+		else
+			pacer.present(window);
 	}
 
-	SDL_GL_DeleteContext(gl_context);
-	SDL_DestroyWindow(window);
+	if (headless)
+	{
+		headless->report(std::cout, profiler);
+		state.report(std::cout);
+	}
 }
 catch (std::exception const & e)
 {
@@ -0,0 +1,53 @@
+#version 330 core
+
+// Evaluates the curve on the GPU: control points are read straight from the
+// control point vertex buffer (bound as an R32F buffer texture, `vertex_stride`
+// floats per vertex), so only the points themselves ever need to be uploaded
+
+uniform mat4 view;
+uniform samplerBuffer control_points;
+uniform int vertex_stride;
+uniform int point_count;
+uniform int segments;
+uniform vec4 curve_color;
+
+out vec4 color;
+
+// bezier_rescale_high and bezier_rescale_low in bezier.h: 2^64 and 2^-64
+const float rescale_high = 18446744073709551616.0;
+const float rescale_low = 5.42101086242752217e-20;
+
+vec2 control_point(int i)
+{
+	return vec2(texelFetch(control_points, i * vertex_stride).r, texelFetch(control_points, i * vertex_stride + 1).r);
+}
+
+void main()
+{
+	float t = float(gl_VertexID) / float(segments);
+	float u = 1.0 - t;
+	int n = point_count - 1;
+
+	// Bernstein form with nested multiplication, divided by the sum of the
+	// weights and rescaled outside [2^-64, 2^64], same as bezier() on the CPU
+	vec2 acc = control_point(0);
+	float w = 1.0;
+	float weights = 1.0;
+	for (int i = 1; i <= n; ++i)
+	{
+		w *= t * (float(n - i + 1) / float(i));
+		acc = acc * u + w * control_point(i);
+		weights = weights * u + w;
+		if (weights > rescale_high || weights < rescale_low)
+		{
+			float scale = weights > rescale_high ? rescale_low : rescale_high;
+			w *= scale;
+			acc *= scale;
+			weights *= scale;
+		}
+	}
+	vec2 position = acc / weights;
+
+	gl_Position = view * vec4(position, 0.0, 1.0);
+	color = curve_color;
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstdint>
+
+#include "vector_math.h"
+
+struct vertex
+{
+	vec2 position;
+	std::uint8_t color[4];
+};
@@ -12,99 +12,30 @@
 #include <iostream>
 #include <chrono>
 #include <vector>
-#include <map>
-
-std::string to_string(std::string_view str)
-{
-	return std::string(str.begin(), str.end());
-}
-
-void sdl2_fail(std::string_view message)
-{
-	throw std::runtime_error(to_string(message) + SDL_GetError());
-}
-
-void glew_fail(std::string_view message, GLenum error)
-{
-	throw std::runtime_error(to_string(message) + reinterpret_cast<const char *>(glewGetErrorString(error)));
-}
-
-const char vertex_shader_source[] =
-R"(#version 330 core
-
-uniform mat4 view;
-uniform mat4 transform;
-
-layout (location = 0) in vec3 in_position;
-layout (location = 1) in vec4 in_color;
-
-out vec4 color;
-
-void main()
-{
-	gl_Position = view * transform * vec4(in_position, 1.0);
-	color = in_color;
-}
-)";
-
-const char fragment_shader_source[] =
-R"(#version 330 core
-
-in vec4 color;
-
-layout (location = 0) out vec4 out_color;
-
-void main()
-{
-	out_color = color;
-}
-)";
-
-GLuint create_shader(GLenum type, const char * source)
-{
-	GLuint result = glCreateShader(type);
-	glShaderSource(result, 1, &source, nullptr);
-	glCompileShader(result);
-	GLint status;
-	glGetShaderiv(result, GL_COMPILE_STATUS, &status);
-	if (status != GL_TRUE)
-	{
-		GLint info_log_length;
-		glGetShaderiv(result, GL_INFO_LOG_LENGTH, &info_log_length);
-		std::string info_log(info_log_length, '\0');
-		glGetShaderInfoLog(result, info_log.size(), nullptr, info_log.data());
-		throw std::runtime_error("Shader compilation failed: " + info_log);
-	}
-	return result;
-}
-
-GLuint create_program(GLuint vertex_shader, GLuint fragment_shader)
-{
-	GLuint result = glCreateProgram();
-	glAttachShader(result, vertex_shader);
-	glAttachShader(result, fragment_shader);
-	glLinkProgram(result);
-
-	GLint status;
-	glGetProgramiv(result, GL_LINK_STATUS, &status);
-	if (status != GL_TRUE)
-	{
-		GLint info_log_length;
-		glGetProgramiv(result, GL_INFO_LOG_LENGTH, &info_log_length);
-		std::string info_log(info_log_length, '\0');
-		glGetProgramInfoLog(result, info_log.size(), nullptr, info_log.data());
-		throw std::runtime_error("Program linkage failed: " + info_log);
-	}
-
-	return result;
-}
-
-struct vec3
-{
-	float x;
-	float y;
-	float z;
-};
+#include <cmath>
+#include <memory>
+#include <optional>
+#include <algorithm>
+#include <string>
+#include "gl_window.h"
+#include "shader.h"
+#include "program_cache.h"
+#include "program_compiler.h"
+#include "program_library.h"
+#include "file_watcher.h"
+#include "uniform_buffer.h"
+#include "vector_math.h"
+#include "profiler.h"
+#include "gl_state.h"
+#include "draw_queue.h"
+#include "vertex_format.h"
+#include "mesh.h"
+#include "culling.h"
+#include "gpu_culling.h"
+#include "thread_pool.h"
+#include "benchmark.h"
+#include "frame_pacer.h"
+#include "input_state.h"
 
 struct vertex
 {
@@ -146,6 +77,13 @@ static vertex cube_vertices[]
 	{{ 1.f,  1.f,  1.f}, {  0,   0, 255, 255}},
 };
 
+// Column-major, as expected by a mat4 vertex attribute (and by the
+// default layout of the per-object uniform block)
+struct instance
+{
+	mat4 transform;
+};
+
 static std::uint32_t cube_indices[]
 {
 	// -X
@@ -162,62 +100,314 @@ static std::uint32_t cube_indices[]
 	20, 21, 22, 22, 21, 23,
 };
 
-int main() try
+// How the cubes are submitted; `I` cycles through the modes
+enum class draw_mode
+{
+	// One glDrawElementsInstanced with a per-instance transform attribute
+	instanced,
+	// One glDrawElements per cube, transforms in a uniform ring
+	per_draw,
+	// One draw per cube through the sorting draw_queue, which merges them
+	// into multi-draws; the transform is selected with the base instance
+	queued,
+};
+
+// Where off-screen cubes are dropped; `C` cycles through the modes
+enum class cull_mode
+{
+	none,
+	// cull_grid on the CPU, only the survivors are uploaded and drawn
+	cpu,
+	// gpu_culler in a compute shader, for the instanced mode only (the
+	// others fall back to the CPU)
+	gpu,
+};
+
+int main(int argc, char ** argv) try
 {
-	if (SDL_Init(SDL_INIT_VIDEO) != 0)
-		sdl2_fail("SDL_Init: ");
-
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
-	SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
-	SDL_GL_SetAttribute(SDL_GL_MULTISAMPLEBUFFERS, 1);
-	SDL_GL_SetAttribute(SDL_GL_MULTISAMPLESAMPLES, 4);
-	SDL_GL_SetAttribute(SDL_GL_RED_SIZE, 8);
-	SDL_GL_SetAttribute(SDL_GL_GREEN_SIZE, 8);
-	SDL_GL_SetAttribute(SDL_GL_BLUE_SIZE, 8);
-	SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
-
-	SDL_Window * window = SDL_CreateWindow("Graphics course practice 4",
-		SDL_WINDOWPOS_CENTERED,
-		SDL_WINDOWPOS_CENTERED,
-		800, 600,
-		SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE | SDL_WINDOW_MAXIMIZED);
-
-	if (!window)
-		sdl2_fail("SDL_CreateWindow: ");
-
-	int width, height;
-	SDL_GetWindowSize(window, &width, &height);
-
-	SDL_GLContext gl_context = SDL_GL_CreateContext(window);
-	if (!gl_context)
-		sdl2_fail("SDL_GL_CreateContext: ");
-
-	if (auto result = glewInit(); result != GLEW_NO_ERROR)
-		glew_fail("glewInit: ", result);
-
-	if (!GLEW_VERSION_3_3)
-		throw std::runtime_error("OpenGL 3.3 is not supported");
+	std::vector<std::string_view> args;
+	auto options = parse_benchmark_options(argc, argv, &args);
+
+	draw_mode mode = draw_mode::instanced;
+	cull_mode culling = cull_mode::cpu;
+	std::string mesh_path;
+	for (std::size_t i = 0; i < args.size(); ++i)
+	{
+		auto arg = args[i];
+		if (arg == "--per-draw")
+			mode = draw_mode::per_draw;
+		else if (arg == "--queued")
+			mode = draw_mode::queued;
+		else if (arg == "--no-cull")
+			culling = cull_mode::none;
+		else if (arg == "--gpu-cull")
+			culling = cull_mode::gpu;
+		else if (arg == "--mesh" && i + 1 < args.size())
+			mesh_path = args[++i];
+		else
+			throw std::runtime_error("Unknown argument: " + std::string(arg));
+	}
+
+	gl_window window("Graphics course practice 4", options.window_flags(), {.samples = 4, .depth_size = 24});
+	frame_pacer pacer(options.pacing);
+
+	int width = window.width(), height = window.height();
 
 	glClearColor(0.8f, 0.8f, 1.f, 0.f);
 
-	auto vertex_shader = create_shader(GL_VERTEX_SHADER, vertex_shader_source);
-	auto fragment_shader = create_shader(GL_FRAGMENT_SHADER, fragment_shader_source);
-	auto program = create_program(vertex_shader, fragment_shader);
+	frame_profiler profiler("Graphics course practice 4");
+	auto & prepare_section = profiler.cpu_section("prepare");
+	auto & draw_section = profiler.cpu_section("draw");
+
+	std::unique_ptr<benchmark> headless;
+	if (options.headless)
+	{
+		headless = std::make_unique<benchmark>(options, "practice4");
+		width = headless->width();
+		height = headless->height();
+	}
+
+	program_cache shader_cache;
+	program_compiler shader_compiler(shader_cache);
+	// Benchmarks measure fixed shaders, only interactive runs watch them
+	std::optional<file_watcher> watcher;
+	if (!headless)
+		watcher.emplace();
+	program_library shaders(shader_compiler, PRACTICE_SHADER_DIR, watcher ? &*watcher : nullptr);
+	auto program_handle = shaders.add("cube.vert", "color.frag", [](gl_program const & program)
+	{
+		bind_uniform_block(program, "camera", camera_binding);
+		bind_uniform_block(program, "object", object_binding);
+	});
+	auto instanced_program_handle = shaders.add("cube_instanced.vert", "color.frag", [](gl_program const & program)
+	{
+		bind_uniform_block(program, "camera", camera_binding);
+	});
+
+	gl_vertex_array vao;
+	gl_buffer vbo, ebo, instance_vbo;
+	glBindVertexArray(vao);
+
+	// Cube corners are exactly +-1, so snorm16 positions lose nothing:
+	// 12 bytes per vertex instead of 16, and 24 vertices fit 16-bit indices.
+	// A mesh given with --mesh replaces the cube; it is scaled into the same
+	// box so that its positions fit snorm16 too, and colored by its normals.
+	vertex_layout model_layout;
+	model_layout.add(0, 3, attribute_type::snorm16).add(1, 4, attribute_type::unorm8);
+
+	std::vector<std::uint8_t> model_vertex_data;
+	packed_indices model_index_data;
+	if (mesh_path.empty())
+	{
+		model_vertex_data.resize(std::size(cube_vertices) * model_layout.stride());
+		for (std::size_t i = 0; i < std::size(cube_vertices); ++i)
+		{
+			auto const & v = cube_vertices[i];
+			auto * dst = model_vertex_data.data() + i * model_layout.stride();
+			model_layout.encode(dst, 0, {v.position.x, v.position.y, v.position.z, 1.f});
+			model_layout.encode(dst, 1, vec4{float(v.color[0]), float(v.color[1]), float(v.color[2]), float(v.color[3])} * (1.f / 255.f));
+		}
+		model_index_data = pack_indices(cube_indices, std::size(cube_vertices));
+	}
+	else
+	{
+		auto mesh = load_obj(mesh_path);
+		float const acmr_before = average_cache_miss_ratio(mesh.indices, mesh.vertices.size());
+		optimize_mesh(mesh);
+		std::cout << mesh_path << ": " << mesh.indices.size() / 3 << " triangles, ACMR " << acmr_before
+			<< " -> " << average_cache_miss_ratio(mesh.indices, mesh.vertices.size()) << std::endl;
+
+		vec3 const center = (mesh.bounds_min + mesh.bounds_max) * 0.5f;
+		vec3 const extent = (mesh.bounds_max - mesh.bounds_min) * 0.5f;
+		float const scale = 1.f / std::max({extent.x, extent.y, extent.z, 1e-6f});
+
+		auto buffers = build_mesh_buffers(mesh, model_layout, [&](mesh_vertex const & v, std::uint8_t * dst){
+			vec3 const p = (v.position - center) * scale;
+			vec3 const c = v.normal * 0.5f + vec3{0.5f, 0.5f, 0.5f};
+			model_layout.encode(dst, 0, {p.x, p.y, p.z, 1.f});
+			model_layout.encode(dst, 1, {c.x, c.y, c.z, 1.f});
+		});
+		model_vertex_data = std::move(buffers.vertex_data);
+		model_index_data = std::move(buffers.indices);
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glBufferData(GL_ARRAY_BUFFER, model_vertex_data.size(), model_vertex_data.data(), GL_STATIC_DRAW);
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, model_index_data.data.size(), model_index_data.data.data(), GL_STATIC_DRAW);
+
+	model_layout.apply();
+
+	// Cubes laid out on a square grid in the XZ plane
+	const int cube_count = options.scene_size > 0 ? options.scene_size : 10000;
+	const int grid_size = std::ceil(std::sqrt(float(cube_count)));
+	const float grid_spacing = 3.f;
+
+	auto instance_attributes = [](GLuint buffer){
+		glBindBuffer(GL_ARRAY_BUFFER, buffer);
+		for (int column = 0; column < 4; ++column)
+		{
+			glEnableVertexAttribArray(2 + column);
+			glVertexAttribPointer(2 + column, 4, GL_FLOAT, GL_FALSE, sizeof(instance), (void *) (offsetof(instance, transform) + 4 * column * sizeof(float)));
+			glVertexAttribDivisor(2 + column, 1);
+		}
+	};
+
+	glBindBuffer(GL_ARRAY_BUFFER, instance_vbo);
+	glBufferData(GL_ARRAY_BUFFER, cube_count * sizeof(instance), nullptr, GL_STREAM_DRAW);
+	instance_attributes(instance_vbo);
+
+	// The model fits into [-1, 1] on every axis, so whatever its spin around
+	// the vertical axis, it stays within sqrt(2) of it horizontally
+	std::vector<aabb> cube_bounds(cube_count);
+	for (int i = 0; i < cube_count; ++i)
+	{
+		float x = (i % grid_size - (grid_size - 1) * 0.5f) * grid_spacing;
+		float z = (i / grid_size - (grid_size - 1) * 0.5f) * grid_spacing;
+		float r = std::sqrt(2.f);
+		cube_bounds[i] = {{x - r, -1.f, z - r}, {x + r, 1.f, z + r}};
+	}
+
+	// 8x8 cubes per cell
+	cull_grid grid(cube_bounds, grid_spacing * 8.f);
 
-	GLuint view_location = glGetUniformLocation(program, "view");
-	GLuint transform_location = glGetUniformLocation(program, "transform");
+	// Same model buffers, with the instance attributes read from the
+	// culler's output
+	std::unique_ptr<gpu_culler> culler;
+	gl_vertex_array culled_vao;
+	if (gpu_culler::supported())
+	{
+		culler = std::make_unique<gpu_culler>(cube_bounds);
+		glBindVertexArray(culled_vao);
+		glBindBuffer(GL_ARRAY_BUFFER, vbo);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+		model_layout.apply();
+		instance_attributes(culler->instances());
+	}
+	else if (culling == cull_mode::gpu)
+		throw std::runtime_error("GPU culling requires GL 4.3");
+
+	// Waits for the first build
+	shaders.get(program_handle);
+
+	// Until the instanced program has finished compiling in the background,
+	// frames are drawn with the per-draw program instead. Headless runs
+	// wait for it, so that every measured frame does the same work.
+	gl_program const * instanced_program = nullptr;
+	if (headless)
+		instanced_program = &shaders.get(instanced_program_handle);
+
+	// The camera is written once per frame and shared by both programs;
+	// per-draw transforms come from a ring, selected with glBindBufferRange
+	uniform_buffer<camera_uniforms> camera(camera_binding);
+	uniform_ring<instance> objects(object_binding, cube_count);
+
+	// Created after the setup above, which binds objects directly
+	gl_state state;
+	draw_queue queue;
+
+	if (mode == draw_mode::queued && !queue.base_instance())
+		throw std::runtime_error("Queued mode requires GL 4.2 or ARB_base_instance");
+
+	// Everything the CPU computes for a frame: the camera, culling, the
+	// transforms and the sort depths. Two of them alternate; while the main
+	// thread submits one, a pool worker prepares the other for the next
+	// frame, from the inputs copied into it when it was started. Input
+	// changes therefore show up one frame later.
+	struct frame_data
+	{
+		float time;
+		int width;
+		int height;
+		draw_mode mode;
+		cull_mode culling;
+		// Set if the GPU culls this frame, then `instances` has every cube
+		bool gpu_culled;
+
+		mat4 view;
+		mat4 projection;
+		std::vector<std::uint32_t> visible;
+		// Transforms of the visible cubes, in the same order
+		std::vector<instance> instances;
+		// View-space distances for the queued mode
+		std::vector<float> depths;
+	};
+
+	auto prepare_frame = [&](frame_data & frame)
+	{
+		float near = 0.1f;
+		float far = 1000.f;
+		float top = near;
+		float right = (top * frame.width) / frame.height;
+
+		float view_angle = M_PI / 6.f;
+		float view_distance = grid_size * grid_spacing * 0.75f;
+
+		frame.view = mat4::translation({0.f, 0.f, -view_distance}) * mat4::rotation_x(view_angle);
+		frame.projection = mat4::frustum(-right, right, -top, top, near, far);
+
+		frame.visible.clear();
+		if (frame.culling == cull_mode::none || frame.gpu_culled)
+		{
+			for (int i = 0; i < cube_count; ++i)
+				frame.visible.push_back(i);
+		}
+		else
+			grid.cull(frustum(frame.projection * frame.view), frame.visible);
+
+		// Every cube spins around its own vertical axis
+		frame.instances.resize(frame.visible.size());
+		for (std::size_t k = 0; k < frame.visible.size(); ++k)
+		{
+			int i = frame.visible[k];
+			float x = (i % grid_size - (grid_size - 1) * 0.5f) * grid_spacing;
+			float z = (i / grid_size - (grid_size - 1) * 0.5f) * grid_spacing;
+			float angle = frame.time + i * 0.1f;
+
+			frame.instances[k] = {mat4::translation({x, 0.f, z}) * mat4::rotation_y(angle)};
+		}
+
+		frame.depths.clear();
+		if (frame.mode == draw_mode::queued)
+		{
+			for (auto const & object : frame.instances)
+				frame.depths.push_back(-(frame.view * object.transform[3]).z);
+		}
+	};
+
+	// Declared after the frames, so that its destructor finishes a pending
+	// preparation before they are destroyed
+	frame_data frames[2];
+	thread_pool workers;
+	thread_pool::job next_frame;
+	std::size_t current = 0;
+
+	auto start_frame = [&](frame_data & frame, float frame_time)
+	{
+		frame.time = frame_time;
+		frame.width = width;
+		frame.height = height;
+		frame.mode = mode;
+		frame.culling = culling;
+		frame.gpu_culled = culling == cull_mode::gpu && mode == draw_mode::instanced && instanced_program;
+		next_frame = workers.async([&prepare_frame, &frame]{ prepare_frame(frame); });
+	};
 
 	auto last_frame_start = std::chrono::high_resolution_clock::now();
 
-	float time = 0.f;
+	float time = headless ? benchmark::time_step : 0.f;
+	start_frame(frames[current], time);
 
-	std::map<SDL_Keycode, bool> button_down;
+	input_state input;
 
 	bool running = true;
 	while (running)
 	{
+		if (!headless)
+			pacer.begin_frame();
+
+		input.begin_frame();
 		for (SDL_Event event; SDL_PollEvent(&event);) switch (event.type)
 		{
 		case SDL_QUIT:
@@ -232,49 +422,138 @@ int main() try
 				break;
 			}
 			break;
-		case SDL_KEYDOWN:
-			button_down[event.key.keysym.sym] = true;
-			break;
-		case SDL_KEYUP:
-			button_down[event.key.keysym.sym] = false;
+		default:
+			input.handle(event);
 			break;
 		}
 
 		if (!running)
 			break;
 
+		if (input.pressed(SDL_SCANCODE_C))
+		{
+			if (culling == cull_mode::none)
+				culling = cull_mode::cpu;
+			else if (culling == cull_mode::cpu && culler)
+				culling = cull_mode::gpu;
+			else
+				culling = cull_mode::none;
+		}
+		if (input.pressed(SDL_SCANCODE_I))
+		{
+			if (mode == draw_mode::instanced)
+				mode = draw_mode::per_draw;
+			else if (mode == draw_mode::per_draw && queue.base_instance())
+				mode = draw_mode::queued;
+			else
+				mode = draw_mode::instanced;
+		}
+
 		auto now = std::chrono::high_resolution_clock::now();
 		float dt = std::chrono::duration_cast<std::chrono::duration<float>>(now - last_frame_start).count();
 		last_frame_start = now;
-		time += dt;
+		float const step = headless ? benchmark::time_step : dt;
+
+		profiler.end_frame(dt);
+		profiler.update_overlay(window);
+
+		// Only the time spent waiting shows up here; while the preparation
+		// keeps up with the submission, it is close to zero
+		scoped_timer prepare_timer(prepare_section);
+		next_frame.wait();
+		prepare_timer.stop();
+
+		frame_data const & frame = frames[current];
+		current = 1 - current;
+		time += step;
+		start_frame(frames[current], time);
+
+		scoped_timer draw_timer(draw_section);
+		if (headless)
+			headless->begin_frame();
+		profiler.begin_gpu();
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		state.enable(GL_DEPTH_TEST);
+
+		camera.update(
+		{
+			.view = frame.view,
+			.projection = frame.projection,
+		});
+
+		if (watcher)
+			shaders.reload(state, watcher->changes());
+		instanced_program = shaders.try_get(instanced_program_handle);
+
+		auto const & instances = frame.instances;
+		std::size_t const drawn = instances.size();
+
+		// The GPU culler needs every transform, the CPU one only those of
+		// the survivors
+		if (frame.gpu_culled)
+			culler->cull(state, frustum(frame.projection * frame.view), std::span<instance const>(instances), {.count = GLuint(model_index_data.count)});
 
-		glClear(GL_COLOR_BUFFER_BIT);
+		state.bind_vertex_array(vao);
 
-		float view[16] =
+		if (frame.mode != draw_mode::per_draw && instanced_program && !frame.gpu_culled)
 		{
-			1.f, 0.f, 0.f, 0.f,
-			0.f, 1.f, 0.f, 0.f,
-			0.f, 0.f, 1.f, 0.f,
-			0.f, 0.f, 0.f, 1.f,
-		};
+			// Orphan the previous frame's data so that the update never waits for the GPU
+			glBindBuffer(GL_ARRAY_BUFFER, instance_vbo);
+			glBufferData(GL_ARRAY_BUFFER, cube_count * sizeof(instance), nullptr, GL_STREAM_DRAW);
+			glBufferSubData(GL_ARRAY_BUFFER, 0, drawn * sizeof(instance), instances.data());
+		}
 
-		float transform[16] =
+		if (frame.gpu_culled)
+		{
+			state.bind_vertex_array(culled_vao);
+			state.use_program(*instanced_program);
+			culler->draw(GL_TRIANGLES, model_index_data.type);
+		}
+		else if (frame.mode == draw_mode::instanced && instanced_program)
+		{
+			state.use_program(*instanced_program);
+			glDrawElementsInstanced(GL_TRIANGLES, model_index_data.count, model_index_data.type, nullptr, drawn);
+		}
+		else if (frame.mode == draw_mode::queued && instanced_program)
+		{
+			draw_state cube_state{.program = *instanced_program, .vertex_array = vao, .index_type = model_index_data.type};
+			for (std::size_t i = 0; i < drawn; ++i)
+				queue.submit(cube_state, {.count = GLuint(model_index_data.count), .base_instance = GLuint(i)}, frame.depths[i]);
+			queue.flush(state);
+		}
+		else
 		{
-			1.f, 0.f, 0.f, 0.f,
-			0.f, 1.f, 0.f, 0.f,
-			0.f, 0.f, 1.f, 0.f,
-			0.f, 0.f, 0.f, 1.f,
-		};
+			objects.begin_frame(drawn);
+			for (std::size_t i = 0; i < drawn; ++i)
+				objects.set(i, instances[i]);
+			objects.end_writes();
 
-		glUseProgram(program);
-		glUniformMatrix4fv(view_location, 1, GL_TRUE, view);
-		glUniformMatrix4fv(transform_location, 1, GL_TRUE, transform);
+			state.use_program(shaders.get(program_handle));
+			for (std::size_t i = 0; i < drawn; ++i)
+			{
+				objects.bind(i);
+				glDrawElements(GL_TRIANGLES, model_index_data.count, model_index_data.type, nullptr);
+			}
+			objects.end_frame();
+		}
+
+		profiler.end_gpu();
+		draw_timer.stop();
 
-		SDL_GL_SwapWindow(window);
+		// The cubes never stop spinning
+		pacer.invalidate();
+
+		if (headless)
+			running = headless->end_frame();
+		else
+			pacer.present(window);
 	}
 
-	SDL_GL_DeleteContext(gl_context);
-	SDL_DestroyWindow(window);
+	if (headless)
+	{
+		headless->report(std::cout, profiler);
+		state.report(std::cout);
+	}
 }
 catch (std::exception const & e)
 {
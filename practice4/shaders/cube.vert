@@ -0,0 +1,23 @@
+#version 330 core
+
+layout (std140) uniform camera
+{
+	mat4 view;
+	mat4 projection;
+};
+
+layout (std140) uniform object
+{
+	mat4 transform;
+};
+
+layout (location = 0) in vec3 in_position;
+layout (location = 1) in vec4 in_color;
+
+out vec4 color;
+
+void main()
+{
+	gl_Position = projection * view * transform * vec4(in_position, 1.0);
+	color = in_color;
+}
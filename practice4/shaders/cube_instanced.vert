@@ -0,0 +1,22 @@
+#version 330 core
+
+// Same as cube.vert, but the transform is a per-instance attribute
+// (locations 2-5, one column each) instead of a uniform block
+
+layout (std140) uniform camera
+{
+	mat4 view;
+	mat4 projection;
+};
+
+layout (location = 0) in vec3 in_position;
+layout (location = 1) in vec4 in_color;
+layout (location = 2) in mat4 in_transform;
+
+out vec4 color;
+
+void main()
+{
+	gl_Position = projection * view * in_transform * vec4(in_position, 1.0);
+	color = in_color;
+}
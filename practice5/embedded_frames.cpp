@@ -0,0 +1,56 @@
+#include "embedded_frames.h"
+
+#ifdef PRACTICE_FRAMES_FILE
+
+// The assembler copies the file into the object as it is, so the compiler
+// never sees its contents: no multi-megabyte initializer to parse, and the
+// data takes exactly its own size in the executable
+
+#define EMBED_STRINGIFY(x) #x
+#define EMBED_EXPAND(x) EMBED_STRINGIFY(x)
+// Some targets (Mach-O, 32-bit Windows) prefix C symbols with an underscore
+#define EMBED_SYMBOL(name) EMBED_EXPAND(__USER_LABEL_PREFIX__) #name
+
+// The section stack puts the assembler back into whatever section the
+// compiler had switched to before this block. The COFF assembler of
+// MinGW has no stack; file-scope asm is emitted ahead of all code and
+// data there, while the assembler is still in .text.
+#if defined(__APPLE__)
+#define EMBED_SECTION_BEGIN ".pushsection __DATA,__const"
+#define EMBED_SECTION_END ".popsection"
+#elif defined(_WIN32)
+#define EMBED_SECTION_BEGIN ".section .rdata,\"dr\""
+#define EMBED_SECTION_END ".text"
+#else
+#define EMBED_SECTION_BEGIN ".pushsection .rodata"
+#define EMBED_SECTION_END ".popsection"
+#endif
+
+// 16-byte alignment keeps the frame table naturally aligned
+__asm__(
+	EMBED_SECTION_BEGIN "\n"
+	".balign 16\n"
+	".globl " EMBED_SYMBOL(practice5_frames_begin) "\n"
+	EMBED_SYMBOL(practice5_frames_begin) ":\n"
+	".incbin \"" PRACTICE_FRAMES_FILE "\"\n"
+	".globl " EMBED_SYMBOL(practice5_frames_end) "\n"
+	EMBED_SYMBOL(practice5_frames_end) ":\n"
+	EMBED_SECTION_END "\n"
+);
+
+extern "C" std::uint8_t const practice5_frames_begin[];
+extern "C" std::uint8_t const practice5_frames_end[];
+
+std::span<std::uint8_t const> embedded_frames()
+{
+	return {practice5_frames_begin, practice5_frames_end};
+}
+
+#else
+
+std::span<std::uint8_t const> embedded_frames()
+{
+	return {};
+}
+
+#endif
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+// The packed test_image.frames, linked into the executable at build time.
+// Empty if the build doesn't embed it (MSVC has no .incbin).
+std::span<std::uint8_t const> embedded_frames();
@@ -0,0 +1,51 @@
+// Packs raw frames (width x height x channels bytes each, back to back)
+// into a frame sequence file that practice5 embeds or maps at runtime
+
+#include "frame_sequence.h"
+#include "mapped_file.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+int main(int argc, char ** argv) try
+{
+	std::vector<std::string_view> args(argv + 1, argv + argc);
+
+	frame_codec codec = frame_codec::raw;
+	if (!args.empty() && args.front() == "--lz4")
+	{
+		codec = frame_codec::lz4;
+		args.erase(args.begin());
+	}
+
+	if (args.size() != 5)
+	{
+		std::cerr << "Usage: " << argv[0] << " [--lz4] <input> <output.frames> <width> <height> <channels>" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	std::string const input_path(args[0]);
+	std::string const output_path(args[1]);
+	std::uint32_t const width = std::stoul(std::string(args[2]));
+	std::uint32_t const height = std::stoul(std::string(args[3]));
+	std::uint32_t const channels = std::stoul(std::string(args[4]));
+
+	mapped_file input(input_path);
+	std::size_t const frame_size = std::size_t(width) * height * channels;
+	if (frame_size == 0 || input.size() == 0 || input.size() % frame_size != 0)
+		throw std::runtime_error(input_path + " is not a whole number of " + std::to_string(width) + "x" + std::to_string(height) + "x" + std::to_string(channels) + " frames");
+
+	std::vector<std::uint8_t const *> frames;
+	for (std::size_t offset = 0; offset < input.size(); offset += frame_size)
+		frames.push_back(input.data() + offset);
+
+	write_frame_sequence(output_path, width, height, channels, frames, codec);
+}
+catch (std::exception const & e)
+{
+	std::cerr << e.what() << std::endl;
+	return EXIT_FAILURE;
+}
@@ -0,0 +1,125 @@
+#include "frame_sequence.h"
+#include "lz4.h"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace
+{
+
+constexpr char frame_sequence_magic[4] = {'F', 'R', 'M', 'S'};
+constexpr std::uint32_t frame_sequence_version = 1;
+
+}
+
+frame_sequence::frame_sequence(std::string const & path)
+	: file_(std::in_place, path)
+	, data_(file_->bytes())
+{
+	parse(path);
+}
+
+frame_sequence::frame_sequence(std::span<std::uint8_t const> data, std::string const & name)
+	: data_(data)
+{
+	parse(name);
+}
+
+std::span<std::uint8_t const> frame_sequence::frame(std::uint32_t index) const
+{
+	auto const & entry = table_[index];
+	return data_.subspan(entry.offset, entry.size);
+}
+
+void frame_sequence::read_frame(std::uint32_t index, void * dst) const
+{
+	auto payload = frame(index);
+	if (header_.codec == frame_codec::lz4)
+		lz4_decompress(payload, {static_cast<std::uint8_t *>(dst), frame_size()});
+	else
+		std::memcpy(dst, payload.data(), payload.size());
+}
+
+void frame_sequence::parse(std::string const & name)
+{
+	if (data_.size() < sizeof(header_))
+		throw std::runtime_error(name + ": truncated frame sequence header");
+
+	std::memcpy(&header_, data_.data(), sizeof(header_));
+
+	if (std::memcmp(header_.magic, frame_sequence_magic, sizeof(frame_sequence_magic)) != 0)
+		throw std::runtime_error(name + ": not a frame sequence");
+	if (header_.version != frame_sequence_version)
+		throw std::runtime_error(name + ": unsupported frame sequence version " + std::to_string(header_.version));
+	if (header_.codec != frame_codec::raw && header_.codec != frame_codec::lz4)
+		throw std::runtime_error(name + ": unsupported frame codec " + std::to_string(std::uint32_t(header_.codec)));
+
+	std::size_t table_end = sizeof(header_) + std::size_t(header_.frame_count) * sizeof(frame_table_entry);
+	if (data_.size() < table_end)
+		throw std::runtime_error(name + ": truncated frame table");
+
+	// The header is 32 bytes, so the table is naturally aligned inside a
+	// mapping; embedded data has to be aligned by whoever embeds it
+	if (reinterpret_cast<std::uintptr_t>(data_.data()) % alignof(frame_table_entry) != 0)
+		throw std::runtime_error(name + ": misaligned frame sequence");
+	table_ = {reinterpret_cast<frame_table_entry const *>(data_.data() + sizeof(header_)), header_.frame_count};
+
+	for (auto const & entry : table_)
+	{
+		if (entry.offset > data_.size() || entry.size > data_.size() - entry.offset)
+			throw std::runtime_error(name + ": frame outside of file bounds");
+		if (header_.codec == frame_codec::raw && entry.size != frame_size())
+			throw std::runtime_error(name + ": raw frame size mismatch");
+	}
+}
+
+void write_frame_sequence(std::string const & path, std::uint32_t width, std::uint32_t height,
+	std::uint32_t channels, std::vector<std::uint8_t const *> const & frames, frame_codec codec)
+{
+	std::ofstream out(path, std::ios::binary);
+	if (!out)
+		throw std::runtime_error("Failed to open " + path + " for writing");
+
+	frame_sequence_header header;
+	std::memcpy(header.magic, frame_sequence_magic, sizeof(frame_sequence_magic));
+	header.version = frame_sequence_version;
+	header.width = width;
+	header.height = height;
+	header.channels = channels;
+	header.frame_count = frames.size();
+	header.codec = codec;
+	header.reserved = 0;
+
+	std::size_t const frame_size = std::size_t(width) * height * channels;
+
+	// Compressed frames are all kept until the table in front of them is known
+	std::vector<std::span<std::uint8_t const>> payloads;
+	std::vector<std::vector<std::uint8_t>> compressed;
+	compressed.reserve(frames.size());
+	for (auto frame : frames)
+	{
+		std::span<std::uint8_t const> pixels(frame, frame_size);
+		if (codec == frame_codec::lz4)
+			payloads.push_back(compressed.emplace_back(lz4_compress(pixels)));
+		else
+			payloads.push_back(pixels);
+	}
+
+	std::vector<frame_table_entry> table(frames.size());
+	std::uint64_t offset = sizeof(header) + table.size() * sizeof(frame_table_entry);
+	for (std::size_t i = 0; i < table.size(); ++i)
+	{
+		table[i].offset = offset;
+		table[i].size = payloads[i].size();
+		offset += payloads[i].size();
+	}
+
+	out.write(reinterpret_cast<char const *>(&header), sizeof(header));
+	out.write(reinterpret_cast<char const *>(table.data()), table.size() * sizeof(frame_table_entry));
+	for (auto payload : payloads)
+		out.write(reinterpret_cast<char const *>(payload.data()), payload.size());
+
+	if (!out)
+		throw std::runtime_error("Failed to write " + path);
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "mapped_file.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <span>
+#include <vector>
+
+// On-disk frame sequence container (all integers are little-endian):
+//
+//     header       magic "FRMS", version, width, height, channels, frame count, codec
+//     frame table  frame count x { u64 offset, u64 size }, offsets from the start of the file
+//     frames       frame payloads, tightly packed
+//
+// Frames are stored row-major, top row first, `channels` bytes per pixel,
+// either as they are or as one LZ4 block each. The file is memory-mapped
+// (or embedded into the executable) and frame payloads are only touched
+// when read, so opening a sequence doesn't depend on its length.
+
+enum class frame_codec : std::uint32_t
+{
+	raw = 0,
+	// Decoded into the caller's memory by read_frame()
+	lz4 = 1,
+};
+
+struct frame_sequence_header
+{
+	char magic[4];
+	std::uint32_t version;
+	std::uint32_t width;
+	std::uint32_t height;
+	std::uint32_t channels;
+	std::uint32_t frame_count;
+	frame_codec codec;
+	std::uint32_t reserved;
+};
+
+struct frame_table_entry
+{
+	std::uint64_t offset;
+	std::uint64_t size;
+};
+
+class frame_sequence
+{
+public:
+	explicit frame_sequence(std::string const & path);
+	// Reads a sequence already in memory, which must outlive the object;
+	// `name` only appears in error messages
+	frame_sequence(std::span<std::uint8_t const> data, std::string const & name);
+
+	std::uint32_t width() const { return header_.width; }
+	std::uint32_t height() const { return header_.height; }
+	std::uint32_t channels() const { return header_.channels; }
+	std::uint32_t frame_count() const { return header_.frame_count; }
+	frame_codec codec() const { return header_.codec; }
+
+	// Size of a decoded frame in bytes
+	std::size_t frame_size() const { return std::size_t(header_.width) * header_.height * header_.channels; }
+
+	// Stored payload of a frame: the pixels themselves for raw frames
+	std::span<std::uint8_t const> frame(std::uint32_t index) const;
+
+	// Decodes a frame into `dst`, which must hold frame_size() bytes;
+	// safe to call from several threads at once
+	void read_frame(std::uint32_t index, void * dst) const;
+
+private:
+	// Empty for a sequence in memory
+	std::optional<mapped_file> file_;
+	std::span<std::uint8_t const> data_;
+	frame_sequence_header header_;
+	std::span<frame_table_entry const> table_;
+
+	void parse(std::string const & name);
+};
+
+void write_frame_sequence(std::string const & path, std::uint32_t width, std::uint32_t height,
+	std::uint32_t channels, std::vector<std::uint8_t const *> const & frames, frame_codec codec = frame_codec::raw);
@@ -0,0 +1,164 @@
+#include "lz4.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+namespace
+{
+
+constexpr std::size_t min_match = 4;
+// The format requires the last 5 bytes to be literals and the last match
+// to start at least 12 bytes before the end
+constexpr std::size_t last_literals = 5;
+constexpr std::size_t match_limit = 12;
+constexpr std::size_t max_offset = 65535;
+constexpr int hash_bits = 16;
+
+std::uint32_t read32(std::uint8_t const * p)
+{
+	std::uint32_t value;
+	std::memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+std::uint32_t hash(std::uint32_t sequence)
+{
+	return (sequence * 2654435761u) >> (32 - hash_bits);
+}
+
+// Lengths of 15 and more continue in bytes of 255 and a final smaller one
+void write_length(std::vector<std::uint8_t> & out, std::size_t length)
+{
+	for (; length >= 255; length -= 255)
+		out.push_back(255);
+	out.push_back(std::uint8_t(length));
+}
+
+void write_literals(std::vector<std::uint8_t> & out, std::uint8_t token, std::uint8_t const * literals, std::size_t count)
+{
+	out.push_back(std::uint8_t((count < 15 ? count : 15) << 4) | token);
+	if (count >= 15)
+		write_length(out, count - 15);
+	out.insert(out.end(), literals, literals + count);
+}
+
+[[noreturn]] void malformed()
+{
+	throw std::runtime_error("Malformed LZ4 block");
+}
+
+std::size_t read_length(std::span<std::uint8_t const> src, std::size_t & ip)
+{
+	std::size_t length = 0;
+	for (std::uint8_t byte = 255; byte == 255; length += byte)
+	{
+		if (ip >= src.size())
+			malformed();
+		byte = src[ip++];
+	}
+	return length;
+}
+
+}
+
+std::vector<std::uint8_t> lz4_compress(std::span<std::uint8_t const> src)
+{
+	std::uint8_t const * p = src.data();
+	std::size_t const n = src.size();
+
+	std::vector<std::uint8_t> out;
+	out.reserve(n + n / 255 + 16);
+
+	std::size_t anchor = 0;
+	if (n >= match_limit)
+	{
+		// Last position of the most recent occurrence of every hashed sequence
+		std::vector<std::size_t> table(std::size_t(1) << hash_bits, 0);
+
+		for (std::size_t ip = 0; ip <= n - match_limit;)
+		{
+			std::uint32_t const sequence = read32(p + ip);
+			std::size_t const candidate = std::exchange(table[hash(sequence)], ip);
+			if (candidate >= ip || ip - candidate > max_offset || read32(p + candidate) != sequence)
+			{
+				++ip;
+				continue;
+			}
+
+			std::size_t length = min_match;
+			while (ip + length < n - last_literals && p[candidate + length] == p[ip + length])
+				++length;
+
+			std::size_t const extra = length - min_match;
+			write_literals(out, std::uint8_t(extra < 15 ? extra : 15), p + anchor, ip - anchor);
+			std::size_t const offset = ip - candidate;
+			out.push_back(std::uint8_t(offset));
+			out.push_back(std::uint8_t(offset >> 8));
+			if (extra >= 15)
+				write_length(out, extra - 15);
+
+			ip += length;
+			anchor = ip;
+		}
+	}
+
+	write_literals(out, 0, p + anchor, n - anchor);
+	return out;
+}
+
+void lz4_decompress(std::span<std::uint8_t const> src, std::span<std::uint8_t> dst)
+{
+	std::size_t ip = 0;
+	std::size_t op = 0;
+	while (true)
+	{
+		if (ip >= src.size())
+			malformed();
+		std::uint8_t const token = src[ip++];
+
+		std::size_t literals = token >> 4;
+		if (literals == 15)
+			literals += read_length(src, ip);
+		if (literals > src.size() - ip || literals > dst.size() - op)
+			malformed();
+		std::copy_n(src.data() + ip, literals, dst.data() + op);
+		ip += literals;
+		op += literals;
+
+		// Only the last sequence has no match
+		if (ip == src.size())
+			break;
+
+		if (src.size() - ip < 2)
+			malformed();
+		std::size_t const offset = src[ip] | (std::size_t(src[ip + 1]) << 8);
+		ip += 2;
+		if (offset == 0 || offset > op)
+			malformed();
+
+		std::size_t length = token & 15;
+		if (length == 15)
+			length += read_length(src, ip);
+		length += min_match;
+		if (length > dst.size() - op)
+			malformed();
+
+		// Matches may overlap their own output, e.g. a repeated pixel has an
+		// offset of 3 and any length
+		std::uint8_t * out = dst.data() + op;
+		std::uint8_t const * match = out - offset;
+		if (offset >= length)
+			std::memcpy(out, match, length);
+		else
+		{
+			for (std::size_t i = 0; i < length; ++i)
+				out[i] = match[i];
+		}
+		op += length;
+	}
+
+	if (op != dst.size())
+		malformed();
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// LZ4 block format (no frame header, no checksums): the payload of one
+// compressed frame sequence entry. Decoding runs at several GB/s, so frames
+// can stay compressed in memory and be decoded whenever they are read.
+
+// Greedy single-pass compressor with a 4-byte hash; fast rather than tight
+std::vector<std::uint8_t> lz4_compress(std::span<std::uint8_t const> src);
+
+// Decodes `src` into exactly dst.size() bytes; throws std::runtime_error on
+// malformed input instead of reading or writing out of bounds
+void lz4_decompress(std::span<std::uint8_t const> src, std::span<std::uint8_t> dst);
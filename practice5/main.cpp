@@ -12,235 +12,439 @@
 #include <iostream>
 #include <chrono>
 #include <vector>
-#include <map>
 #include <cmath>
-#include "test_image.h"
+#include <memory>
+#include <optional>
+#include <cstring>
+#include <algorithm>
+#include <random>
+#include <span>
+#include "frame_sequence.h"
+#include "embedded_frames.h"
+#include "texture_streamer.h"
+#include "texture_compression.h"
+#include "procedural_texture.h"
+#include "thread_pool.h"
+#include "gl_window.h"
+#include "error.h"
+#include "shader.h"
+#include "program_cache.h"
+#include "program_compiler.h"
+#include "program_library.h"
+#include "file_watcher.h"
+#include "uniform_buffer.h"
+#include "vertex_format.h"
+#include "vector_math.h"
+#include "profiler.h"
+#include "gl_state.h"
+#include "benchmark.h"
+#include "frame_pacer.h"
+#include "input_state.h"
+#include "transparency.h"
 
-std::string to_string(std::string_view str)
+struct vertex
 {
-	return std::string(str.begin(), str.end());
-}
+	vec3 position;
+    vec2 texcoords;
+};
 
-void sdl2_fail(std::string_view message)
+static vertex plane_vertices[]
 {
-	throw std::runtime_error(to_string(message) + SDL_GetError());
-}
+	{{-10.f, 0.f, -10.f}, {0.f, 0.f}},
+	{{-10.f, 0.f,  10.f}, {0.f, 1.f}},
+	{{ 10.f, 0.f, -10.f}, {1.f, 0.f}},
+	{{ 10.f, 0.f,  10.f}, {1.f, 1.f}},
+};
 
-void glew_fail(std::string_view message, GLenum error)
+// Translucent planes are this quad, placed and tinted per instance
+static vertex quad_vertices[]
 {
-	throw std::runtime_error(to_string(message) + reinterpret_cast<const char *>(glewGetErrorString(error)));
-}
-
-const char vertex_shader_source[] =
-R"(#version 330 core
-
-uniform mat4 view;
-uniform mat4 projection;
-
-layout (location = 0) in vec3 in_position;
-layout (location = 1) in vec2 in_texcoords;
-
-out vec2 texcoords;
+	{{-1.f, -1.f, 0.f}, {0.f, 1.f}},
+	{{-1.f,  1.f, 0.f}, {0.f, 0.f}},
+	{{ 1.f, -1.f, 0.f}, {1.f, 1.f}},
+	{{ 1.f,  1.f, 0.f}, {1.f, 0.f}},
+};
 
-void main()
+// Attributes 2-5 (the transform, one column each) and 6
+struct translucent_instance
 {
-	gl_Position = projection * view * vec4(in_position, 1.0);
-	texcoords = in_texcoords;
-}
-)";
-
-const char fragment_shader_source[] =
-R"(#version 330 core
-
-uniform sampler2D tex;
-uniform sampler2D img;
-
-in vec2 texcoords;
-
-layout (location = 0) out vec4 out_color;
+	mat4 transform;
+	vec4 tint;
+};
 
-void main()
+static std::uint32_t plane_indices[]
 {
-	out_color = (texture(tex, texcoords) + texture(img, texcoords)) / 2;
-}
-)";
+	0, 1, 2, 2, 1, 3,
+};
 
-GLuint create_shader(GLenum type, const char * source)
+std::string default_frames_path()
 {
-	GLuint result = glCreateShader(type);
-	glShaderSource(result, 1, &source, nullptr);
-	glCompileShader(result);
-	GLint status;
-	glGetShaderiv(result, GL_COMPILE_STATUS, &status);
-	if (status != GL_TRUE)
+	std::string result = "test_image.frames";
+	if (char * base_path = SDL_GetBasePath())
 	{
-		GLint info_log_length;
-		glGetShaderiv(result, GL_INFO_LOG_LENGTH, &info_log_length);
-		std::string info_log(info_log_length, '\0');
-		glGetShaderInfoLog(result, info_log.size(), nullptr, info_log.data());
-		throw std::runtime_error("Shader compilation failed: " + info_log);
+		result = base_path + result;
+		SDL_free(base_path);
 	}
 	return result;
 }
 
-GLuint create_program(GLuint vertex_shader, GLuint fragment_shader)
+int main(int argc, char ** argv) try
 {
-	GLuint result = glCreateProgram();
-	glAttachShader(result, vertex_shader);
-	glAttachShader(result, fragment_shader);
-	glLinkProgram(result);
-
-	GLint status;
-	glGetProgramiv(result, GL_LINK_STATUS, &status);
-	if (status != GL_TRUE)
+	std::vector<std::string_view> args;
+	auto options = parse_benchmark_options(argc, argv, &args);
+
+	// Empty for the embedded frames, which builds without them replace
+	// with the packed file next to the executable
+	std::string frames_path = embedded_frames().empty() ? default_frames_path() : std::string();
+	bool allow_compression = true;
+	// Sorting costs CPU time per plane, OIT costs fill rate per pixel;
+	// which one is cheaper depends on the plane count and their size
+	transparency_mode transparency = transparency_mode::sorted;
+	// The translucent planes are opt-in: they move every frame, which
+	// would give up the on-demand redraws of the default scene
+	std::optional<int> plane_option;
+	bool transparency_option = false;
+	for (std::size_t i = 0; i < args.size(); ++i)
 	{
-		GLint info_log_length;
-		glGetProgramiv(result, GL_INFO_LOG_LENGTH, &info_log_length);
-		std::string info_log(info_log_length, '\0');
-		glGetProgramInfoLog(result, info_log.size(), nullptr, info_log.data());
-		throw std::runtime_error("Program linkage failed: " + info_log);
+		auto arg = args[i];
+		if (arg == "--uncompressed")
+			allow_compression = false;
+		else if (arg == "--transparency" && i + 1 < args.size())
+		{
+			auto value = args[++i];
+			transparency_option = true;
+			if (value == "sorted")
+				transparency = transparency_mode::sorted;
+			else if (value == "oit")
+				transparency = transparency_mode::weighted_oit;
+			else
+				throw std::runtime_error("--transparency must be sorted or oit, not " + to_string(value));
+		}
+		else if (arg == "--planes" && i + 1 < args.size())
+			plane_option = std::max(std::stoi(to_string(args[++i])), 0);
+		else
+			frames_path = to_string(arg);
 	}
+	int const translucent_count = plane_option ? *plane_option : transparency_option ? 256 : 0;
 
-	return result;
-}
+	gl_window window("Graphics course practice 5", options.window_flags(), {.samples = 4, .depth_size = 24});
+	frame_pacer pacer(options.pacing);
 
-struct vec3
-{
-	float x;
-	float y;
-	float z;
-};
+	int width = window.width(), height = window.height();
 
-struct vec2 {
-    float x;
-    float y;
-};
+	glClearColor(0.8f, 0.8f, 1.f, 0.f);
 
-struct vertex
-{
-	vec3 position;
-    vec2 texcoords;
-};
+	frame_profiler profiler("Graphics course practice 5");
+	auto & sort_section = profiler.cpu_section("sort");
+	auto & draw_section = profiler.cpu_section("draw");
 
-static vertex plane_vertices[]
-{
-	{{-10.f, 0.f, -10.f}, {0.f, 0.f}},
-	{{-10.f, 0.f,  10.f}, {0.f, 1.f}},
-	{{ 10.f, 0.f, -10.f}, {1.f, 0.f}},
-	{{ 10.f, 0.f,  10.f}, {1.f, 1.f}},
-};
+	std::unique_ptr<benchmark> headless;
+	if (options.headless)
+	{
+		headless = std::make_unique<benchmark>(options, "practice5");
+		width = headless->width();
+		height = headless->height();
+	}
 
-static std::uint32_t plane_indices[]
-{
-	0, 1, 2, 2, 1, 3,
-};
+	const bool compress_textures = allow_compression && bc1_supported();
+
+	// Mip chains are built on the CPU by these workers instead of glGenerateMipmap
+	thread_pool texture_workers;
+
+	// The program compiles while the textures and frames below are loaded
+	program_cache shader_cache;
+	program_compiler shader_compiler(shader_cache);
+	// Benchmarks measure fixed assets, only interactive runs watch them
+	std::optional<file_watcher> watcher;
+	if (!headless)
+		watcher.emplace();
+	program_library shaders(shader_compiler, PRACTICE_SHADER_DIR, watcher ? &*watcher : nullptr);
+	GLint frame_location = -1;
+	auto program_handle = shaders.add("plane.vert", "plane.frag", [&](gl_program const & program)
+	{
+		bind_uniform_block(program, "camera", camera_binding);
+		// Sampler units never change, so they are set once per program
+		glUseProgram(program);
+		glUniform1i(program.uniform("tex"), 0);
+		glUniform1i(program.uniform("img"), 1);
+		frame_location = program.uniform("frame");
+	});
+
+	GLint sorted_frame_location = -1;
+	GLint oit_frame_location = -1;
+	auto translucent_link = [](GLint & location)
+	{
+		return [&location](gl_program const & program)
+		{
+			bind_uniform_block(program, "camera", camera_binding);
+			glUseProgram(program);
+			glUniform1i(program.uniform("img"), 1);
+			location = program.uniform("frame");
+		};
+	};
+	auto sorted_program_handle = shaders.add("translucent.vert", "translucent.frag", translucent_link(sorted_frame_location));
+	auto oit_program_handle = shaders.add("translucent.vert", "translucent_oit.frag", translucent_link(oit_frame_location));
+	// The ground again, without any shading, as the occluder of the OIT targets
+	auto depth_program_handle = shaders.add("plane.vert", "depth_only.frag", [](gl_program const & program)
+	{
+		bind_uniform_block(program, "camera", camera_binding);
+	});
 
-int main() try
-{
-	if (SDL_Init(SDL_INIT_VIDEO) != 0)
-		sdl2_fail("SDL_Init: ");
-
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
-	SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
-	SDL_GL_SetAttribute(SDL_GL_MULTISAMPLEBUFFERS, 1);
-	SDL_GL_SetAttribute(SDL_GL_MULTISAMPLESAMPLES, 4);
-	SDL_GL_SetAttribute(SDL_GL_RED_SIZE, 8);
-	SDL_GL_SetAttribute(SDL_GL_GREEN_SIZE, 8);
-	SDL_GL_SetAttribute(SDL_GL_BLUE_SIZE, 8);
-	SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
-
-	SDL_Window * window = SDL_CreateWindow("Graphics course practice 5",
-		SDL_WINDOWPOS_CENTERED,
-		SDL_WINDOWPOS_CENTERED,
-		800, 600,
-		SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE | SDL_WINDOW_MAXIMIZED);
-
-	if (!window)
-		sdl2_fail("SDL_CreateWindow: ");
-
-	int width, height;
-	SDL_GetWindowSize(window, &width, &height);
-
-	SDL_GLContext gl_context = SDL_GL_CreateContext(window);
-	if (!gl_context)
-		sdl2_fail("SDL_GL_CreateContext: ");
-
-	if (auto result = glewInit(); result != GLEW_NO_ERROR)
-		glew_fail("glewInit: ", result);
-
-	if (!GLEW_VERSION_3_3)
-		throw std::runtime_error("OpenGL 3.3 is not supported");
+    gl_vertex_array vao;
+    gl_buffer vbo, ebo;
+	glBindVertexArray(vao);
 
-	glClearColor(0.8f, 0.8f, 1.f, 0.f);
+	// Half-float positions are exact for the plane corners and unorm16 texture coordinates
+	// cover [0, 1] in 1/65535 steps: 12 bytes per vertex instead of 20
+	vertex_layout plane_layout;
+	plane_layout.add(0, 3, attribute_type::float16).add(1, 2, attribute_type::unorm16);
 
-	auto vertex_shader = create_shader(GL_VERTEX_SHADER, vertex_shader_source);
-	auto fragment_shader = create_shader(GL_FRAGMENT_SHADER, fragment_shader_source);
-	auto program = create_program(vertex_shader, fragment_shader);
+	auto encode_vertices = [&](std::span<vertex const> vertices)
+	{
+		std::vector<std::uint8_t> result(vertices.size() * plane_layout.stride());
+		for (std::size_t i = 0; i < vertices.size(); ++i)
+		{
+			auto const & v = vertices[i];
+			auto * dst = result.data() + i * plane_layout.stride();
+			plane_layout.encode(dst, 0, {v.position.x, v.position.y, v.position.z, 1.f});
+			plane_layout.encode(dst, 1, {v.texcoords.x, v.texcoords.y, 0.f, 0.f});
+		}
+		return result;
+	};
+	auto const plane_vertex_data = encode_vertices(plane_vertices);
+	auto const plane_index_data = pack_indices(plane_indices, std::size(plane_vertices));
+
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glBufferData(GL_ARRAY_BUFFER, plane_vertex_data.size(), plane_vertex_data.data(), GL_STATIC_DRAW);
 
-	GLuint view_location = glGetUniformLocation(program, "view");
-	GLuint projection_location = glGetUniformLocation(program, "projection");
-    GLuint tex_location = glGetUniformLocation(program, "tex");
-    GLuint tex_img_location = glGetUniformLocation(program, "tex");
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, plane_index_data.data.size(), plane_index_data.data.data(), GL_STATIC_DRAW);
 
-    GLuint vao, vbo, ebo;
-	glGenVertexArrays(1, &vao);
-	glBindVertexArray(vao);
+	plane_layout.apply();
 
-	glGenBuffers(1, &vbo);
-	glBindBuffer(GL_ARRAY_BUFFER, vbo);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(plane_vertices), plane_vertices, GL_STATIC_DRAW);
+	// The quad shares the plane's indices; the instance buffer is
+	// rewritten every frame
+	auto const quad_vertex_data = encode_vertices(quad_vertices);
+	gl_vertex_array quad_vao;
+	gl_buffer quad_vbo, translucent_vbo;
+	glBindVertexArray(quad_vao);
 
-	glGenBuffers(1, &ebo);
+	glBindBuffer(GL_ARRAY_BUFFER, quad_vbo);
+	glBufferData(GL_ARRAY_BUFFER, quad_vertex_data.size(), quad_vertex_data.data(), GL_STATIC_DRAW);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(plane_indices), plane_indices, GL_STATIC_DRAW);
+	plane_layout.apply();
 
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(vertex), (void *) (offsetof(vertex, position)));
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(vertex), (void *) (offsetof(vertex, texcoords)));
+	glBindBuffer(GL_ARRAY_BUFFER, translucent_vbo);
+	glBufferData(GL_ARRAY_BUFFER, translucent_count * sizeof(translucent_instance), nullptr, GL_STREAM_DRAW);
+	for (int column = 0; column < 4; ++column)
+	{
+		glEnableVertexAttribArray(2 + column);
+		glVertexAttribPointer(2 + column, 4, GL_FLOAT, GL_FALSE, sizeof(translucent_instance), (void *) (offsetof(translucent_instance, transform) + 4 * column * sizeof(float)));
+		glVertexAttribDivisor(2 + column, 1);
+	}
+	glEnableVertexAttribArray(6);
+	glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(translucent_instance), (void *) offsetof(translucent_instance, tint));
+	glVertexAttribDivisor(6, 1);
+
+	// Every plane circles the center at its own radius, height and speed
+	struct translucent_plane
+	{
+		float radius;
+		float height;
+		float phase;
+		float speed;
+		vec4 tint;
+	};
+	std::vector<translucent_plane> translucent_planes(translucent_count);
+	{
+		std::mt19937 random(5);
+		auto uniform = [&](float min, float max){ return std::uniform_real_distribution<float>(min, max)(random); };
+		for (auto & plane : translucent_planes)
+			plane = {uniform(1.f, 9.f), uniform(1.f, 4.f), uniform(0.f, 2.f * M_PI), uniform(-0.5f, 0.5f),
+				{uniform(0.4f, 1.f), uniform(0.4f, 1.f), uniform(0.4f, 1.f), uniform(0.2f, 0.6f)}};
+	}
 
-    GLuint texture;
-    glGenTextures(1, &texture);
+    gl_texture texture;
     glBindTexture(GL_TEXTURE_2D, texture);
-    glTexParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-
-    GLuint img_w = 1024, img_h = 1024;
-    std::vector<std::uint8_t> color;
-    for (int x = 0; x < img_w; x++) {
-        for (int y = 0; y < img_h; y++) {
-            int res = ((x + y) % 2) * 255;
-            color.push_back(res);
-            color.push_back(res);
-            color.push_back(res);
-            color.push_back(255);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+
+    // `--scene` sets the checkerboard size; levels 1-3 are replaced below, so it must be at least 8
+    GLuint img_w = options.scene_size > 0 ? options.scene_size : 1024, img_h = img_w;
+    if (img_w < 8)
+        throw std::runtime_error("Checkerboard texture must be at least 8x8");
+
+    // Level 0 is a one-pixel checkerboard, levels 1-3 are solid red, green and blue.
+    // All of them are generated in parallel straight into the memory they are uploaded from.
+    const image_chain checkerboard_layout = mip_chain_layout(img_w, img_h);
+    auto level_pixels = [&](std::uint8_t * base, std::size_t level) {
+        return reinterpret_cast<std::uint32_t *>(base + checkerboard_layout.levels[level].offset);
+    };
+    auto generate_checkerboard_base = [&](std::uint8_t * base) {
+        generate_checkerboard(level_pixels(base, 0), img_w, img_h, 1, 0xff000000u, 0xffffffffu, &texture_workers);
+    };
+    auto generate_colored_levels = [&](std::uint8_t * base) {
+        std::uint32_t const colors[] = {0xff0000ffu, 0xffff0000u, 0xff00ff00u};
+        for (std::size_t level = 1; level <= 3; level++) {
+            auto const & l = checkerboard_layout.levels[level];
+            generate_solid(level_pixels(base, level), l.width, l.height, colors[level - 1], &texture_workers);
         }
+    };
+
+    if (compress_textures) {
+        // glGenerateMipmap can't produce compressed levels,
+        // so the whole chain is built and compressed up front
+        image_chain chain = checkerboard_layout;
+        chain.data.resize(chain.total_size());
+        generate_checkerboard_base(chain.data.data());
+        generate_mip_chain(chain, chain.data.data(), 4, chain.data.data(), &texture_workers);
+        generate_colored_levels(chain.data.data());
+
+        auto compressed = compress_bc1(chain);
+        upload_mip_chain(compressed, compressed.data.data(), false);
+    } else {
+        auto const & last = checkerboard_layout.levels[3];
+        const std::size_t upload_size = last.offset + last.size;
+
+        gl_buffer unpack_buffer;
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, unpack_buffer);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, upload_size, nullptr, GL_STREAM_DRAW);
+        auto * mapped = static_cast<std::uint8_t *>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, upload_size,
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+        if (!mapped)
+            throw std::runtime_error("Failed to map the checkerboard upload buffer");
+        generate_checkerboard_base(mapped);
+        generate_colored_levels(mapped);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+        auto level_offset = [&](std::size_t level) {
+            return (void const *) checkerboard_layout.levels[level].offset;
+        };
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, img_w, img_h, 0, GL_RGBA, GL_UNSIGNED_BYTE, level_offset(0));
+        glGenerateMipmap(GL_TEXTURE_2D);
+
+        glTexImage2D(GL_TEXTURE_2D, 1, GL_RGBA8, img_w >> 1, img_h >> 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, level_offset(1));
+        glTexImage2D(GL_TEXTURE_2D, 2, GL_RGBA8, img_w >> 2, img_h >> 2, 0, GL_RGBA, GL_UNSIGNED_BYTE, level_offset(2));
+        glTexImage2D(GL_TEXTURE_2D, 3, GL_RGBA8, img_w >> 3, img_h >> 3, 0, GL_RGBA, GL_UNSIGNED_BYTE, level_offset(3));
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
     }
 
+    frame_sequence frames = frames_path.empty() ? frame_sequence(embedded_frames(), "embedded frames") : frame_sequence(frames_path);
+    if (frames.channels() != 3 && frames.channels() != 4)
+        throw std::runtime_error("Frame sequence must have 3 or 4 channels");
+
+    int frame_count = frames.frame_count();
+    const std::size_t frame_size = frames.frame_size();
+    const GLsizei frame_w = frames.width(), frame_h = frames.height();
+    const int frame_channels = frames.channels();
+
+    GLint max_layers = 0;
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &max_layers);
+    if (frame_count > max_layers)
+        throw std::runtime_error("Frame sequence has more frames than an array texture can hold");
+
+    // Every frame, with its whole mip chain, becomes one layer of an array texture,
+    // so playing the animation only changes the layer the shader samples
+    const image_chain raw_layout = mip_chain_layout(frame_w, frame_h);
+    const image_chain frame_layout = compress_textures ? bc1_layout(raw_layout) : raw_layout;
+
+    // Binds the new texture directly, like the rest of the setup
+    auto create_frames_texture = [](image_chain const & layout, int layers) {
+        gl_texture result;
+        glBindTexture(GL_TEXTURE_2D_ARRAY, result);
+        allocate_mip_chain_array(layout, layers);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);
+        return result;
+    };
 
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, img_w, img_h, 0, GL_RGBA, GL_UNSIGNED_BYTE, color.data());
-    glGenerateMipmap(GL_TEXTURE_2D);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    gl_texture tex_img = create_frames_texture(frame_layout, frame_count);
+
+    {
+        // Frames are decoded, mipmapped (and compressed) into pixel buffers on a separate
+        // thread one step ahead, overlapping with the GPU-side transfer of the previous one
+        texture_streamer frame_streamer(frame_layout.total_size(), 3,
+            [&, pixels = std::vector<std::uint8_t>(frame_size)](int frame, void * dst) mutable {
+                frames.read_frame(frame, pixels.data());
+                if (compress_textures) {
+                    auto compressed = compress_bc1(build_mip_chain(pixels.data(), frame_w, frame_h, frame_channels, &texture_workers));
+                    std::memcpy(dst, compressed.data.data(), compressed.data.size());
+                } else {
+                    generate_mip_chain(raw_layout, pixels.data(), frame_channels, static_cast<std::uint8_t *>(dst), &texture_workers);
+                }
+            });
+
+        frame_streamer.prefetch(0);
+        for (int i = 0; i < frame_count; i++) {
+            if (i + 1 < frame_count)
+                frame_streamer.prefetch(i + 1);
+            frame_streamer.upload(i, [&](void const * offset){
+                upload_mip_chain_layer(frame_layout, offset, i);
+            });
+        }
+    }
 
-    std::vector<std::uint32_t> red_mipmap(512 * 512, 0xff0000ffu);
-    glTexImage2D(GL_TEXTURE_2D, 1, GL_RGBA8, 512, 512, 0, GL_RGBA, GL_UNSIGNED_BYTE, red_mipmap.data());
+	// Waits for the first builds; their link callbacks bind the programs
+	// directly, which must happen before the gl_state below exists
+	shaders.get(program_handle);
+	shaders.get(sorted_program_handle);
+	shaders.get(oit_program_handle);
+
+	// A changed frame sequence is decoded in the background, straight into
+	// client memory, and replaces the array texture at the start of the
+	// first frame after it is complete. Each reload owns its result, so a
+	// newer change simply supersedes one still in progress.
+	struct decoded_frames
+	{
+		image_chain layout;
+		int count = 0;
+		std::vector<std::uint8_t> data;
+		std::string error;
+	};
+	std::shared_ptr<decoded_frames> reloaded_frames;
+	thread_pool::job frames_reload;
+
+	auto decode_frames = [&texture_workers, frames_path, compress_textures](decoded_frames & result) {
+		frame_sequence sequence(frames_path);
+		if (sequence.channels() != 3 && sequence.channels() != 4)
+			throw std::runtime_error("Frame sequence must have 3 or 4 channels");
+
+		image_chain const raw = mip_chain_layout(sequence.width(), sequence.height());
+		result.layout = compress_textures ? bc1_layout(raw) : raw;
+		result.count = sequence.frame_count();
+
+		std::size_t const layer_size = result.layout.total_size();
+		result.data.resize(result.count * layer_size);
+		std::vector<std::uint8_t> pixels(sequence.frame_size());
+		for (int i = 0; i < result.count; ++i)
+		{
+			std::uint8_t * dst = result.data.data() + i * layer_size;
+			sequence.read_frame(i, pixels.data());
+			if (compress_textures)
+			{
+				auto compressed = compress_bc1(build_mip_chain(pixels.data(), sequence.width(), sequence.height(), sequence.channels(), &texture_workers));
+				std::memcpy(dst, compressed.data.data(), compressed.data.size());
+			}
+			else
+				generate_mip_chain(raw, pixels.data(), sequence.channels(), dst, &texture_workers);
+		}
+	};
 
-    std::vector<std::uint32_t> green_mipmap(256 * 256, 0xffff0000u);
-    glTexImage2D(GL_TEXTURE_2D, 2, GL_RGBA8, 256, 256, 0, GL_RGBA, GL_UNSIGNED_BYTE, green_mipmap.data());
+	if (watcher && !frames_path.empty())
+		watcher->watch(frames_path);
 
-    std::vector<std::uint32_t> blue_mipmap(128 * 128, 0xff00ff00u);
-    glTexImage2D(GL_TEXTURE_2D, 3, GL_RGBA8, 128, 128, 0, GL_RGBA, GL_UNSIGNED_BYTE, blue_mipmap.data());
+	uniform_buffer<camera_uniforms> camera(camera_binding);
 
-    GLuint tex_img;
-    glGenTextures(1, &tex_img);
-    glBindTexture(GL_TEXTURE_2D, tex_img);
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 498, 498, 0, GL_RGB, GL_UNSIGNED_BYTE, test_image_data[0]);
+	weighted_oit oit;
+	depth_sorter sorter;
+	// Kept between frames, so that filling them doesn't allocate
+	std::vector<translucent_instance> translucent_instances(translucent_count);
+	std::vector<translucent_instance> sorted_instances(translucent_count);
+	std::vector<float> translucent_depths(translucent_count);
 
-    glGenerateMipmap(GL_TEXTURE_2D);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);
+	// Created after the setup above, which binds objects directly
+	gl_state state;
 
     auto last_frame_start = std::chrono::high_resolution_clock::now();
 
@@ -250,11 +454,15 @@ int main() try
     int curr_frame = 0;
     bool curr_frame_changed = false;
 
-	std::map<SDL_Keycode, bool> button_down;
+	input_state input;
 
 	bool running = true;
 	while (running)
 	{
+		if (!headless)
+			pacer.begin_frame();
+
+		input.begin_frame();
 		for (SDL_Event event; SDL_PollEvent(&event);) switch (event.type)
 		{
 		case SDL_QUIT:
@@ -269,33 +477,96 @@ int main() try
 				break;
 			}
 			break;
-		case SDL_KEYDOWN:
-			button_down[event.key.keysym.sym] = true;
-			break;
-		case SDL_KEYUP:
-			button_down[event.key.keysym.sym] = false;
+		default:
+			input.handle(event);
 			break;
 		}
 
 		if (!running)
 			break;
 
+		if (input.pressed(SDL_SCANCODE_T))
+			transparency = transparency == transparency_mode::sorted ? transparency_mode::weighted_oit : transparency_mode::sorted;
+
+		// A new program or texture needs the current frame index again
+		bool frame_uniform_stale = false;
+		if (watcher)
+		{
+			auto const changes = watcher->changes();
+			frame_uniform_stale = shaders.reload(state, changes);
+			if (std::find(changes.begin(), changes.end(), frames_path) != changes.end())
+			{
+				auto result = std::make_shared<decoded_frames>();
+				reloaded_frames = result;
+				frames_reload = texture_workers.async([result, decode_frames]{
+					try
+					{
+						decode_frames(*result);
+					}
+					catch (std::exception const & e)
+					{
+						result->error = e.what();
+					}
+				});
+			}
+		}
+
+		if (reloaded_frames && frames_reload.done())
+		{
+			auto const result = std::move(reloaded_frames);
+			if (result->error.empty() && result->count > max_layers)
+				result->error = "Frame sequence has more frames than an array texture can hold";
+
+			if (!result->error.empty())
+				std::cerr << "Keeping the previous frames: " << result->error << std::endl;
+			else
+			{
+				gl_texture replacement = create_frames_texture(result->layout, result->count);
+				std::size_t const layer_size = result->layout.total_size();
+				for (int i = 0; i < result->count; ++i)
+					upload_mip_chain_layer(result->layout, result->data.data() + i * layer_size, i);
+
+				tex_img = std::move(replacement);
+				frame_count = result->count;
+				if (curr_frame >= frame_count)
+					curr_frame = 0;
+				frame_uniform_stale = true;
+				state.invalidate();
+				std::cout << "Reloaded " << frame_count << " frames from " << frames_path << std::endl;
+			}
+		}
+		if (frame_uniform_stale)
+			pacer.invalidate();
+
 		auto now = std::chrono::high_resolution_clock::now();
 		float dt = std::chrono::duration_cast<std::chrono::duration<float>>(now - last_frame_start).count();
 		last_frame_start = now;
-		time += dt;
+		time += headless ? benchmark::time_step : dt;
+
+		profiler.end_frame(dt);
+		profiler.update_overlay(window);
 
         if (time - prev_time >= 0.05f) {
             prev_time = time;
             curr_frame += 1;
             curr_frame_changed = true;
-            if (curr_frame >= 15) curr_frame = 0;
+            if (curr_frame >= frame_count) curr_frame = 0;
         } else {
             curr_frame_changed = false;
         }
 
+		// Only the animation steps need a redraw in the on-demand mode,
+		// unless the translucent planes keep moving
+		pacer.invalidate_after(std::chrono::duration_cast<frame_pacer::clock::duration>(std::chrono::duration<float>(0.05f - (time - prev_time))));
+		if (translucent_count > 0)
+			pacer.invalidate();
+
+		scoped_timer draw_timer(draw_section);
+		if (headless)
+			headless->begin_frame();
+		profiler.begin_gpu();
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-		glEnable(GL_DEPTH_TEST);
+		state.enable(GL_DEPTH_TEST);
 
 		float near = 0.1f;
 		float far = 100.f;
@@ -304,49 +575,100 @@ int main() try
 
 		float view_angle = M_PI / 6.f;
 
-		float view[16] =
+		mat4 const view = mat4::translation({0.f, 0.f, -15.f}) * mat4::rotation_x(view_angle);
+		camera.update(
 		{
-			1.f, 0.f, 0.f, 0.f,
-			0.f, std::cos(view_angle), -std::sin(view_angle), 0.f,
-			0.f, std::sin(view_angle), std::cos(view_angle), -15.f,
-			0.f, 0.f, 0.f, 1.f,
-		};
+			.view = view,
+			.projection = mat4::frustum(-right, right, -top, top, near, far),
+		});
+
+		state.use_program(shaders.get(program_handle));
+		state.bind_texture(0, GL_TEXTURE_2D, texture);
+		state.bind_texture(1, GL_TEXTURE_2D_ARRAY, tex_img);
 
-		float projection[16] =
+        if (curr_frame_changed || frame_uniform_stale)
+            glUniform1i(frame_location, curr_frame);
+
+        state.bind_vertex_array(vao);
+		glDrawElements(GL_TRIANGLES, plane_index_data.count, plane_index_data.type, nullptr);
+
+		if (translucent_count > 0)
 		{
-			near / right, 0.f, 0.f, 0.f,
-			0.f, near / top, 0.f, 0.f,
-			0.f, 0.f, - (far + near) / (far - near), - 2.f * far * near / (far - near),
-			0.f, 0.f, -1.f, 0.f,
-		};
+			for (int i = 0; i < translucent_count; ++i)
+			{
+				auto const & plane = translucent_planes[i];
+				float const angle = plane.phase + time * plane.speed;
+				mat4 const transform = mat4::translation({plane.radius * std::cos(angle), plane.height, plane.radius * std::sin(angle)})
+					* mat4::rotation_y(2.f * angle) * mat4::scale({1.5f, 1.f, 1.f});
+				translucent_instances[i] = {transform, plane.tint};
+				translucent_depths[i] = -(view * transform[3]).z;
+			}
 
-		glUseProgram(program);
-		glUniformMatrix4fv(view_location, 1, GL_TRUE, view);
-		glUniformMatrix4fv(projection_location, 1, GL_TRUE, projection);
-        glUniform1i(tex_location, 0);
-        glUniform1i(tex_img_location, 1);
-
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, texture);
-
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, tex_img);
-        if (curr_frame_changed) {
-            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 498, 498, GL_RGB, GL_UNSIGNED_BYTE, test_image_data[curr_frame]);
-            glGenerateMipmap(GL_TEXTURE_2D);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);
-        }
+			// Only the sorted mode depends on the order of the instances
+			auto const * instances = translucent_instances.data();
+			if (transparency == transparency_mode::sorted)
+			{
+				scoped_timer sort_timer(sort_section);
+				auto const order = sorter.back_to_front(translucent_depths);
+				for (std::size_t i = 0; i < order.size(); ++i)
+					sorted_instances[i] = translucent_instances[order[i]];
+				instances = sorted_instances.data();
+			}
 
-        glBindVertexArray(vao);
-		glDrawElements(GL_TRIANGLES, std::size(plane_indices), GL_UNSIGNED_INT, nullptr);
+			// Orphaned, so that the update never waits for the previous frame's draw
+			std::size_t const size = translucent_count * sizeof(translucent_instance);
+			glBindBuffer(GL_ARRAY_BUFFER, translucent_vbo);
+			glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_STREAM_DRAW);
+			glBufferSubData(GL_ARRAY_BUFFER, 0, size, instances);
 
-		SDL_GL_SwapWindow(window);
+			auto draw_translucent = [&](program_library::handle program, GLint frame)
+			{
+				state.use_program(shaders.get(program));
+				state.bind_texture(1, GL_TEXTURE_2D_ARRAY, tex_img);
+				glUniform1i(frame, curr_frame);
+				state.bind_vertex_array(quad_vao);
+				glDrawElementsInstanced(GL_TRIANGLES, plane_index_data.count, plane_index_data.type, nullptr, translucent_count);
+			};
+
+			if (transparency == transparency_mode::sorted)
+			{
+				// Tested against the opaque depth, but not written, since
+				// everything behind has already been drawn
+				glDepthMask(GL_FALSE);
+				state.enable(GL_BLEND);
+				glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+				draw_translucent(sorted_program_handle, sorted_frame_location);
+				state.disable(GL_BLEND);
+				glDepthMask(GL_TRUE);
+			}
+			else
+			{
+				// The ground is the only occluder; its depth is laid down
+				// again without the texture fetches of the plane program
+				oit.begin(state, width, height);
+				state.use_program(shaders.get(depth_program_handle));
+				state.bind_vertex_array(vao);
+				glDrawElements(GL_TRIANGLES, plane_index_data.count, plane_index_data.type, nullptr);
+				oit.accumulate(state);
+				draw_translucent(oit_program_handle, oit_frame_location);
+				oit.resolve(state);
+			}
+		}
+
+		profiler.end_gpu();
+		draw_timer.stop();
+
+		if (headless)
+			running = headless->end_frame();
+		else
+			pacer.present(window);
 	}
 
-	SDL_GL_DeleteContext(gl_context);
-	SDL_DestroyWindow(window);
+	if (headless)
+	{
+		headless->report(std::cout, profiler);
+		state.report(std::cout);
+	}
 }
 catch (std::exception const & e)
 {
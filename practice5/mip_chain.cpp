@@ -0,0 +1,224 @@
+#include "mip_chain.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace
+{
+
+// Averages 2x2 pixel blocks of the RGBA rows `r0` and `r1` into `dst_width`
+// pixels, rounding to nearest; both rows hold at least 2 * dst_width pixels
+void downsample_row(std::uint8_t const * r0, std::uint8_t const * r1, std::uint8_t * dst, GLsizei dst_width)
+{
+	GLsizei x = 0;
+
+#if defined(__AVX2__)
+	__m256i const zero = _mm256_setzero_si256();
+	__m256i const two = _mm256_set1_epi16(2);
+	for (; x + 4 <= dst_width; x += 4)
+	{
+		__m256i a = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(r0 + 8 * x));
+		__m256i b = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(r1 + 8 * x));
+		// Per 128-bit lane: lo = pixels 0, 1 and hi = pixels 2, 3 widened to 16 bits
+		__m256i lo = _mm256_add_epi16(_mm256_unpacklo_epi8(a, zero), _mm256_unpacklo_epi8(b, zero));
+		__m256i hi = _mm256_add_epi16(_mm256_unpackhi_epi8(a, zero), _mm256_unpackhi_epi8(b, zero));
+		__m256i sum = _mm256_add_epi16(_mm256_unpacklo_epi64(lo, hi), _mm256_unpackhi_epi64(lo, hi));
+		sum = _mm256_srli_epi16(_mm256_add_epi16(sum, two), 2);
+		__m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(sum, sum), 0x08);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 4 * x), _mm256_castsi256_si128(packed));
+	}
+#elif defined(__SSE2__) || defined(_M_X64)
+	__m128i const zero = _mm_setzero_si128();
+	__m128i const two = _mm_set1_epi16(2);
+	for (; x + 2 <= dst_width; x += 2)
+	{
+		__m128i a = _mm_loadu_si128(reinterpret_cast<__m128i const *>(r0 + 8 * x));
+		__m128i b = _mm_loadu_si128(reinterpret_cast<__m128i const *>(r1 + 8 * x));
+		// lo = pixels 0, 1 and hi = pixels 2, 3 widened to 16 bits
+		__m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+		__m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+		__m128i sum = _mm_add_epi16(_mm_unpacklo_epi64(lo, hi), _mm_unpackhi_epi64(lo, hi));
+		sum = _mm_srli_epi16(_mm_add_epi16(sum, two), 2);
+		_mm_storel_epi64(reinterpret_cast<__m128i *>(dst + 4 * x), _mm_packus_epi16(sum, sum));
+	}
+#elif defined(__ARM_NEON)
+	for (; x + 2 <= dst_width; x += 2)
+	{
+		uint8x16_t a = vld1q_u8(r0 + 8 * x);
+		uint8x16_t b = vld1q_u8(r1 + 8 * x);
+		uint16x8_t lo = vaddl_u8(vget_low_u8(a), vget_low_u8(b));
+		uint16x8_t hi = vaddl_u8(vget_high_u8(a), vget_high_u8(b));
+		uint16x8_t sum = vcombine_u16(
+			vadd_u16(vget_low_u16(lo), vget_high_u16(lo)),
+			vadd_u16(vget_low_u16(hi), vget_high_u16(hi)));
+		vst1_u8(dst + 4 * x, vrshrn_n_u16(sum, 2));
+	}
+#endif
+
+	for (; x < dst_width; ++x)
+		for (int c = 0; c < 4; ++c)
+		{
+			unsigned sum = r0[8 * x + c] + r0[8 * x + 4 + c] + r1[8 * x + c] + r1[8 * x + 4 + c];
+			dst[4 * x + c] = (sum + 2) / 4;
+		}
+}
+
+void downsample(std::uint8_t const * src, GLsizei src_width, GLsizei src_height,
+	std::uint8_t * dst, GLsizei dst_width, GLsizei dst_y_begin, GLsizei dst_y_end)
+{
+	for (GLsizei y = dst_y_begin; y < dst_y_end; ++y)
+	{
+		auto const * r0 = src + std::size_t(std::min(2 * y, src_height - 1)) * src_width * 4;
+		auto const * r1 = src + std::size_t(std::min(2 * y + 1, src_height - 1)) * src_width * 4;
+		auto * row = dst + std::size_t(y) * dst_width * 4;
+
+		if (src_width == 1)
+		{
+			// Only the vertical direction is being reduced
+			for (int c = 0; c < 4; ++c)
+				row[c] = (r0[c] + r1[c] + 1) / 2;
+		}
+		else
+			downsample_row(r0, r1, row, dst_width);
+	}
+}
+
+void expand_rows(std::uint8_t const * src, int channels, std::uint8_t * dst, GLsizei width, GLsizei y_begin, GLsizei y_end)
+{
+	std::size_t const begin = std::size_t(y_begin) * width, end = std::size_t(y_end) * width;
+	if (channels == 4)
+	{
+		// Nothing to do when the image was generated in place
+		if (src != dst)
+			std::memcpy(dst + begin * 4, src + begin * 4, (end - begin) * 4);
+		return;
+	}
+
+	for (std::size_t i = begin; i < end; ++i)
+	{
+		dst[4 * i + 0] = src[3 * i + 0];
+		dst[4 * i + 1] = src[3 * i + 1];
+		dst[4 * i + 2] = src[3 * i + 2];
+		dst[4 * i + 3] = 255;
+	}
+}
+
+// Runs `body(y_begin, y_end)` over the rows of a level, on the pool if there
+// is enough work to make that worthwhile
+template <typename Body>
+void for_rows(thread_pool * pool, GLsizei width, GLsizei height, Body const & body)
+{
+	constexpr std::size_t min_pixels_per_chunk = 16 * 1024;
+	std::size_t rows_per_chunk = std::max<std::size_t>(1, min_pixels_per_chunk / width);
+
+	if (!pool || pool->thread_count() == 0 || rows_per_chunk >= std::size_t(height))
+	{
+		body(0, height);
+		return;
+	}
+
+	pool->parallel_for(height, rows_per_chunk, [&](std::size_t begin, std::size_t end){
+		body(GLsizei(begin), GLsizei(end));
+	});
+}
+
+}
+
+image_chain mip_chain_layout(GLsizei width, GLsizei height)
+{
+	image_chain result;
+	result.format = GL_RGBA;
+
+	std::size_t total_size = 0;
+	for (GLsizei w = width, h = height;; w = std::max(w / 2, 1), h = std::max(h / 2, 1))
+	{
+		std::size_t size = std::size_t(w) * h * 4;
+		result.levels.push_back({w, h, total_size, size});
+		total_size += size;
+		if (w == 1 && h == 1)
+			break;
+	}
+
+	return result;
+}
+
+void generate_mip_chain(image_chain const & layout, std::uint8_t const * pixels, int channels,
+	std::uint8_t * dst, thread_pool * pool)
+{
+	auto const & base = layout.levels[0];
+	for_rows(pool, base.width, base.height, [&](GLsizei begin, GLsizei end){
+		expand_rows(pixels, channels, dst + base.offset, base.width, begin, end);
+	});
+
+	for (std::size_t i = 1; i < layout.levels.size(); ++i)
+	{
+		auto const & src = layout.levels[i - 1];
+		auto const & level = layout.levels[i];
+		for_rows(pool, level.width, level.height, [&](GLsizei begin, GLsizei end){
+			downsample(dst + src.offset, src.width, src.height, dst + level.offset, level.width, begin, end);
+		});
+	}
+}
+
+image_chain build_mip_chain(std::uint8_t const * pixels, GLsizei width, GLsizei height, int channels,
+	thread_pool * pool)
+{
+	image_chain result = mip_chain_layout(width, height);
+	result.data.resize(result.total_size());
+	generate_mip_chain(result, pixels, channels, result.data.data(), pool);
+	return result;
+}
+
+void upload_mip_chain(image_chain const & chain, void const * base, bool sub_image)
+{
+	auto const * bytes = static_cast<std::uint8_t const *>(base);
+	for (std::size_t i = 0; i < chain.levels.size(); ++i)
+	{
+		auto const & level = chain.levels[i];
+		void const * pixels = bytes + level.offset;
+		if (chain.compressed && sub_image)
+			glCompressedTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, level.width, level.height, chain.format, level.size, pixels);
+		else if (chain.compressed)
+			glCompressedTexImage2D(GL_TEXTURE_2D, i, chain.format, level.width, level.height, 0, level.size, pixels);
+		else if (sub_image)
+			glTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, level.width, level.height, chain.format, GL_UNSIGNED_BYTE, pixels);
+		else
+			glTexImage2D(GL_TEXTURE_2D, i, chain.format, level.width, level.height, 0, chain.format, GL_UNSIGNED_BYTE, pixels);
+	}
+}
+
+void allocate_mip_chain_array(image_chain const & chain, GLsizei layers)
+{
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, chain.levels.size() - 1);
+	for (std::size_t i = 0; i < chain.levels.size(); ++i)
+	{
+		auto const & level = chain.levels[i];
+		if (chain.compressed)
+			glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, i, chain.format, level.width, level.height, layers, 0, level.size * layers, nullptr);
+		else
+			glTexImage3D(GL_TEXTURE_2D_ARRAY, i, GL_RGBA8, level.width, level.height, layers, 0, chain.format, GL_UNSIGNED_BYTE, nullptr);
+	}
+}
+
+void upload_mip_chain_layer(image_chain const & chain, void const * base, GLint layer)
+{
+	auto const * bytes = static_cast<std::uint8_t const *>(base);
+	for (std::size_t i = 0; i < chain.levels.size(); ++i)
+	{
+		auto const & level = chain.levels[i];
+		void const * pixels = bytes + level.offset;
+		if (chain.compressed)
+			glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, i, 0, 0, layer, level.width, level.height, 1, chain.format, level.size, pixels);
+		else
+			glTexSubImage3D(GL_TEXTURE_2D_ARRAY, i, 0, 0, layer, level.width, level.height, 1, chain.format, GL_UNSIGNED_BYTE, pixels);
+	}
+}
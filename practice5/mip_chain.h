@@ -0,0 +1,64 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct image_level
+{
+	GLsizei width;
+	GLsizei height;
+	// Byte range of the level inside image_chain::data
+	std::size_t offset;
+	std::size_t size;
+};
+
+// A full mip chain kept in one contiguous allocation, so that it can be
+// copied into a pixel buffer in one go and uploaded level by level using
+// offsets into that buffer
+struct image_chain
+{
+	// Pixel format (GL_RGB/GL_RGBA) for raw chains,
+	// internal format for compressed ones
+	GLenum format;
+	bool compressed = false;
+	std::vector<image_level> levels;
+	std::vector<std::uint8_t> data;
+
+	std::size_t total_size() const { return levels.back().offset + levels.back().size; }
+};
+
+class thread_pool;
+
+// Layout (levels down to 1x1, offsets, GL_RGBA format) of a raw chain
+// built from a width x height image; `data` is left empty
+image_chain mip_chain_layout(GLsizei width, GLsizei height);
+
+// Fills `dst` (layout.total_size() bytes) with all levels of `layout` built from
+// a 3- or 4-channel image using a 2x2 box filter. Levels are always RGBA8:
+// 3-channel input is expanded, which keeps every row 4-byte aligned and lets
+// the downsampling kernels run on SSE2/AVX2/NEON. Rows of every level are
+// split between the threads of `pool` when one is given. 4-channel
+// `pixels` may already be level 0 of `dst`.
+void generate_mip_chain(image_chain const & layout, std::uint8_t const * pixels, int channels,
+	std::uint8_t * dst, thread_pool * pool = nullptr);
+
+// Convenience wrapper for mip_chain_layout + generate_mip_chain
+image_chain build_mip_chain(std::uint8_t const * pixels, GLsizei width, GLsizei height, int channels,
+	thread_pool * pool = nullptr);
+
+// Uploads every level of the chain into the texture bound to GL_TEXTURE_2D;
+// `base` is either chain.data.data() or an offset into the bound unpack buffer.
+// With `sub_image` the texture storage is expected to exist already.
+// Raw chains are tightly packed, so GL_UNPACK_ALIGNMENT must be 1.
+void upload_mip_chain(image_chain const & chain, void const * base, bool sub_image);
+
+// Creates every level of the chain with `layers` layers (and undefined
+// contents) in the texture bound to GL_TEXTURE_2D_ARRAY
+void allocate_mip_chain_array(image_chain const & chain, GLsizei layers);
+
+// Like upload_mip_chain with `sub_image`, but into layer `layer` of the
+// texture bound to GL_TEXTURE_2D_ARRAY
+void upload_mip_chain_layer(image_chain const & chain, void const * base, GLint layer);
@@ -0,0 +1,107 @@
+#include "procedural_texture.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace
+{
+
+constexpr GLsizei tile_size = 64;
+
+// Writes `count` pixels repeating the 4-pixel pattern `p0 p1 p2 p3`, where
+// pattern[0] lands on dst[0]
+void fill_pattern(std::uint32_t * dst, std::size_t count, std::uint32_t const (&pattern)[4])
+{
+	std::size_t i = 0;
+
+#if defined(__SSE2__) || defined(_M_X64)
+	__m128i const v = _mm_setr_epi32(pattern[0], pattern[1], pattern[2], pattern[3]);
+	for (; i + 16 <= count; i += 16)
+	{
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), v);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i + 4), v);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i + 8), v);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i + 12), v);
+	}
+	for (; i + 4 <= count; i += 4)
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), v);
+#elif defined(__ARM_NEON)
+	uint32x4_t const v = vld1q_u32(pattern);
+	for (; i + 4 <= count; i += 4)
+		vst1q_u32(dst + i, v);
+#endif
+
+	for (; i < count; ++i)
+		dst[i] = pattern[i % 4];
+}
+
+}
+
+void generate_tiles(std::uint32_t * dst, GLsizei width, GLsizei height, tile_row_function const & body, thread_pool * pool)
+{
+	GLsizei const tiles_x = (width + tile_size - 1) / tile_size;
+	GLsizei const tiles_y = (height + tile_size - 1) / tile_size;
+
+	auto run = [&](std::size_t begin, std::size_t end){
+		for (std::size_t tile = begin; tile < end; ++tile)
+		{
+			GLsizei const x_begin = GLsizei(tile % tiles_x) * tile_size, x_end = std::min(x_begin + tile_size, width);
+			GLsizei const y_begin = GLsizei(tile / tiles_x) * tile_size, y_end = std::min(y_begin + tile_size, height);
+			for (GLsizei y = y_begin; y < y_end; ++y)
+				body(dst + std::size_t(y) * width + x_begin, x_begin, x_end, y);
+		}
+	};
+
+	std::size_t const tile_count = std::size_t(tiles_x) * tiles_y;
+	if (!pool || pool->thread_count() == 0 || tile_count == 1)
+	{
+		run(0, tile_count);
+		return;
+	}
+
+	// A whole row of tiles per chunk keeps every chunk's writes contiguous
+	pool->parallel_for(tile_count, tiles_x, run);
+}
+
+void fill_pixels(std::uint32_t * dst, std::size_t count, std::uint32_t color)
+{
+	fill_pattern(dst, count, {color, color, color, color});
+}
+
+void generate_solid(std::uint32_t * dst, GLsizei width, GLsizei height, std::uint32_t color, thread_pool * pool)
+{
+	generate_tiles(dst, width, height, [color](std::uint32_t * row, GLsizei x_begin, GLsizei x_end, GLsizei){
+		fill_pixels(row, x_end - x_begin, color);
+	}, pool);
+}
+
+void generate_checkerboard(std::uint32_t * dst, GLsizei width, GLsizei height, GLsizei cell,
+	std::uint32_t even, std::uint32_t odd, thread_pool * pool)
+{
+	cell = std::max<GLsizei>(cell, 1);
+	generate_tiles(dst, width, height, [=](std::uint32_t * row, GLsizei x_begin, GLsizei x_end, GLsizei y){
+		bool const odd_row = (y / cell) % 2;
+		if (cell == 1)
+		{
+			// Alternates every pixel, which is exactly a 4-pixel pattern
+			std::uint32_t const first = ((x_begin % 2) != odd_row) ? odd : even;
+			std::uint32_t const second = (first == even) ? odd : even;
+			fill_pattern(row, x_end - x_begin, {first, second, first, second});
+			return;
+		}
+
+		// Solid runs up to the next cell boundary
+		for (GLsizei x = x_begin; x < x_end;)
+		{
+			GLsizei const run_end = std::min((x / cell + 1) * cell, x_end);
+			fill_pixels(row + (x - x_begin), run_end - x, ((x / cell) % 2 != odd_row) ? odd : even);
+			x = run_end;
+		}
+	}, pool);
+}
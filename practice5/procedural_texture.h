@@ -0,0 +1,34 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+class thread_pool;
+
+// Load-time generators for RGBA8 images. Colors are packed as they lie in
+// memory, i.e. 0xAABBGGRR on little-endian machines.
+//
+// The image is split into tiles that are generated in parallel by `pool`
+// (when one is given) straight into `dst`, which may be a mapped pixel
+// unpack buffer. Tiles are 64 pixels (four cache lines) wide and are
+// filled row by row with SIMD stores.
+
+// Calls `body(row, x_begin, x_end, y)` for every row segment of every tile;
+// `row` points at pixel x_begin of row y. Tiles are at most 64x64 pixels.
+using tile_row_function = std::function<void(std::uint32_t * row, GLsizei x_begin, GLsizei x_end, GLsizei y)>;
+void generate_tiles(std::uint32_t * dst, GLsizei width, GLsizei height, tile_row_function const & body,
+	thread_pool * pool = nullptr);
+
+// Fills `count` pixels with `color`
+void fill_pixels(std::uint32_t * dst, std::size_t count, std::uint32_t color);
+
+// A width x height image filled with `color`
+void generate_solid(std::uint32_t * dst, GLsizei width, GLsizei height, std::uint32_t color, thread_pool * pool = nullptr);
+
+// Squares of `cell` x `cell` pixels alternating between `even` and `odd`,
+// with `even` in the top-left corner
+void generate_checkerboard(std::uint32_t * dst, GLsizei width, GLsizei height, GLsizei cell,
+	std::uint32_t even, std::uint32_t odd, thread_pool * pool = nullptr);
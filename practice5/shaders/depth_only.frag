@@ -0,0 +1,7 @@
+#version 330 core
+
+// Lays down depth only, e.g. of occluders into the OIT targets
+
+void main()
+{
+}
@@ -0,0 +1,14 @@
+#version 330 core
+
+uniform sampler2D tex;
+uniform sampler2DArray img;
+uniform int frame;
+
+in vec2 texcoords;
+
+layout (location = 0) out vec4 out_color;
+
+void main()
+{
+	out_color = (texture(tex, texcoords) + texture(img, vec3(texcoords, frame))) / 2;
+}
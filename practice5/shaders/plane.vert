@@ -0,0 +1,18 @@
+#version 330 core
+
+layout (std140) uniform camera
+{
+	mat4 view;
+	mat4 projection;
+};
+
+layout (location = 0) in vec3 in_position;
+layout (location = 1) in vec2 in_texcoords;
+
+out vec2 texcoords;
+
+void main()
+{
+	gl_Position = projection * view * vec4(in_position, 1.0);
+	texcoords = in_texcoords;
+}
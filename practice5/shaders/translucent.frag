@@ -0,0 +1,18 @@
+#version 330 core
+
+// Straight alpha, for back-to-front blending with
+// (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA)
+
+uniform sampler2DArray img;
+uniform int frame;
+
+in vec2 texcoords;
+in vec4 tint;
+in float view_depth;
+
+layout (location = 0) out vec4 out_color;
+
+void main()
+{
+	out_color = vec4(texture(img, vec3(texcoords, frame)).rgb * tint.rgb, tint.a);
+}
@@ -0,0 +1,28 @@
+#version 330 core
+
+// Unit quads placed and tinted per instance: the transform is at
+// locations 2-5 (one column each), the tint at 6
+
+layout (std140) uniform camera
+{
+	mat4 view;
+	mat4 projection;
+};
+
+layout (location = 0) in vec3 in_position;
+layout (location = 1) in vec2 in_texcoords;
+layout (location = 2) in mat4 in_transform;
+layout (location = 6) in vec4 in_tint;
+
+out vec2 texcoords;
+out vec4 tint;
+out float view_depth;
+
+void main()
+{
+	vec4 view_position = view * in_transform * vec4(in_position, 1.0);
+	gl_Position = projection * view_position;
+	texcoords = in_texcoords;
+	tint = in_tint;
+	view_depth = -view_position.z;
+}
@@ -0,0 +1,25 @@
+#version 330 core
+
+// Accumulation outputs of weighted blended OIT, see weighted_oit
+
+uniform sampler2DArray img;
+uniform int frame;
+
+in vec2 texcoords;
+in vec4 tint;
+in float view_depth;
+
+layout (location = 0) out vec4 out_sum;
+layout (location = 1) out float out_weight;
+
+void main()
+{
+	vec4 color = vec4(texture(img, vec3(texcoords, frame)).rgb * tint.rgb, tint.a);
+
+	// Equation 9 of McGuire and Bavoil: close surfaces dominate, and the
+	// clamp keeps the sums inside half-float range
+	float weight = clamp(0.03 / (1e-5 + pow(view_depth / 200.0, 4.0)), 1e-2, 3e3);
+
+	out_sum = vec4(color.rgb * color.a * weight, color.a);
+	out_weight = color.a * weight;
+}